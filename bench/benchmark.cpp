@@ -0,0 +1,365 @@
+/* benchmark.cpp
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <ea/profiling.h>
+
+/* Throughput benchmark and regression harness for the examples.
+
+ Each workload (see bench/workloads.txt) runs one of the example programs with
+ its configuration file, a fixed RNG seed, and a set of option overrides that
+ select its scale.  Every run happens in its own directory under bench_runs/,
+ and the harness reports one tab-separated row per workload:
+
+     workload wall_s updates updates_per_s evaluations evaluations_per_s
+     peak_rss_kb latency_p50_us latency_p90_us latency_p99_us latency_max_us
+
+ Evaluation counts and per-update latencies are read from phase_breakdown.dat,
+ and so are only available if the examples were built with LIBEA_PROFILING
+ defined; otherwise those columns are reported as NA.
+
+ Given a baseline (a previous output of this program), each workload's
+ updates/s is compared against it, and any that are slower by more than the
+ tolerance are flagged; the exit status is then non-zero.
+
+ usage: benchmark [--bin dir] [--workloads file] [--output file] [--repeat n]
+                  [--filter substring] [--baseline file] [--tolerance fraction]
+ */
+
+//! A single benchmark workload.
+struct workload {
+    std::string name;
+    std::string example;
+    std::string config;
+    std::vector<std::string> overrides;
+};
+
+//! Measurements from running a workload.
+struct result {
+    result() : wall(0.0), updates(0), evaluations(-1), peak_rss_kb(0) {
+    }
+
+    double wall;
+    long updates;
+    long evaluations;
+    long peak_rss_kb;
+    std::vector<double> latency_us;
+};
+
+//! Returns the current wall-clock time, in seconds.
+double now() {
+    timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+//! Returns an absolute version of path.
+std::string absolute(const std::string& path) {
+    if(!path.empty() && path[0] == '/') {
+        return path;
+    }
+    char buf[4096];
+    if(getcwd(buf, sizeof(buf)) == 0) {
+        throw std::runtime_error("could not determine working directory");
+    }
+    return std::string(buf) + "/" + path;
+}
+
+//! Read workloads from filename, keeping only those whose name contains filter.
+std::vector<workload> read_workloads(const std::string& filename, const std::string& filter) {
+    std::ifstream in(filename.c_str());
+    if(!in.good()) {
+        throw std::runtime_error("could not open workloads file " + filename);
+    }
+    std::vector<workload> w;
+    std::string line;
+    while(std::getline(in, line)) {
+        std::istringstream ls(line);
+        workload x;
+        if(!(ls >> x.name) || x.name[0] == '#') {
+            continue;
+        }
+        ls >> x.example >> x.config;
+        std::string o;
+        while(ls >> o) {
+            x.overrides.push_back(o);
+        }
+        if(x.name.find(filter) != std::string::npos) {
+            w.push_back(x);
+        }
+    }
+    return w;
+}
+
+/*! Returns the number of updates a workload will run: the ea.run.updates
+ override if present, otherwise the "updates" key of its config file.
+ */
+long workload_updates(const workload& w) {
+    const std::string key="--ea.run.updates=";
+    for(std::size_t i=0; i<w.overrides.size(); ++i) {
+        if(w.overrides[i].compare(0, key.size(), key) == 0) {
+            return std::atol(w.overrides[i].c_str() + key.size());
+        }
+    }
+    std::ifstream in(w.config.c_str());
+    std::string line, section;
+    while(std::getline(in, line)) {
+        if(!line.empty() && line[0] == '[') {
+            section = line;
+        } else if(section == "[ea.run]" && line.compare(0, 8, "updates=") == 0) {
+            return std::atol(line.c_str() + 8);
+        }
+    }
+    return 0;
+}
+
+/*! Read per-update latencies and the total number of fitness evaluations from
+ the phase_breakdown.dat written by a profiled run.
+ */
+void read_phase_breakdown(const std::string& filename, double ticks_per_us, result& r) {
+    std::ifstream in(filename.c_str());
+    std::string line;
+    if(!std::getline(in, line)) {
+        return;
+    }
+    std::vector<std::string> header;
+    std::istringstream hs(line);
+    std::string h;
+    while(hs >> h) {
+        header.push_back(h);
+    }
+    std::size_t ticks_col=std::find(header.begin(), header.end(), "update_ticks") - header.begin();
+    std::size_t evals_col=std::find(header.begin(), header.end(), "fitness_calls") - header.begin();
+
+    r.evaluations = 0;
+    while(std::getline(in, line)) {
+        std::istringstream ls(line);
+        std::vector<double> v;
+        double x;
+        while(ls >> x) {
+            v.push_back(x);
+        }
+        if(ticks_col < v.size()) {
+            r.latency_us.push_back(v[ticks_col] / ticks_per_us);
+        }
+        if(evals_col < v.size()) {
+            r.evaluations += static_cast<long>(v[evals_col]);
+        }
+    }
+}
+
+//! Run workload w using the example programs found in bindir.
+result run(const workload& w, const std::string& bindir) {
+    std::string dir="bench_runs/" + w.name;
+    mkdir("bench_runs", 0755);
+    mkdir(dir.c_str(), 0755);
+
+    std::vector<std::string> args;
+    args.push_back(absolute(bindir + "/" + w.example));
+    args.push_back("-c");
+    args.push_back(absolute(w.config));
+    args.push_back("--ea.rng.seed=1");
+    args.insert(args.end(), w.overrides.begin(), w.overrides.end());
+
+    std::vector<char*> argv;
+    for(std::size_t i=0; i<args.size(); ++i) {
+        argv.push_back(const_cast<char*>(args[i].c_str()));
+    }
+    argv.push_back(0);
+
+    boost::uint64_t t0=ealib::profiling::ticks();
+    double w0=now();
+    pid_t pid=fork();
+    if(pid == 0) {
+        if(chdir(dir.c_str()) != 0 || freopen("stdout.txt", "w", stdout) == 0) {
+            _exit(127);
+        }
+        execv(argv[0], &argv[0]);
+        _exit(127);
+    } else if(pid < 0) {
+        throw std::runtime_error(std::string("fork failed: ") + std::strerror(errno));
+    }
+
+    int status=0;
+    rusage ru;
+    if(wait4(pid, &status, 0, &ru) < 0) {
+        throw std::runtime_error(std::string("wait4 failed: ") + std::strerror(errno));
+    }
+    result r;
+    r.wall = now() - w0;
+    boost::uint64_t t1=ealib::profiling::ticks();
+    if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        throw std::runtime_error("workload " + w.name + " failed; see " + dir + "/stdout.txt");
+    }
+
+    r.updates = workload_updates(w);
+    r.peak_rss_kb = ru.ru_maxrss;
+    read_phase_breakdown(dir + "/phase_breakdown.dat", (t1 - t0) / (r.wall * 1e6), r);
+    return r;
+}
+
+//! Returns the p'th percentile of v (which is sorted).
+double percentile(const std::vector<double>& v, double p) {
+    std::size_t i=static_cast<std::size_t>(p * (v.size() - 1) + 0.5);
+    return v[i];
+}
+
+//! Write the header line of the output.
+void write_header(std::ostream& out) {
+    out << "workload\twall_s\tupdates\tupdates_per_s\tevaluations\tevaluations_per_s\t"
+    << "peak_rss_kb\tlatency_p50_us\tlatency_p90_us\tlatency_p99_us\tlatency_max_us" << std::endl;
+}
+
+//! Write the results of workload w.
+void write_result(const workload& w, result& r, std::ostream& out) {
+    out << w.name << "\t" << r.wall << "\t" << r.updates << "\t" << (r.updates / r.wall) << "\t";
+    if(r.evaluations >= 0) {
+        out << r.evaluations << "\t" << (r.evaluations / r.wall) << "\t";
+    } else {
+        out << "NA\tNA\t";
+    }
+    out << r.peak_rss_kb << "\t";
+    if(!r.latency_us.empty()) {
+        std::sort(r.latency_us.begin(), r.latency_us.end());
+        out << percentile(r.latency_us, 0.5) << "\t"
+        << percentile(r.latency_us, 0.9) << "\t"
+        << percentile(r.latency_us, 0.99) << "\t"
+        << r.latency_us.back();
+    } else {
+        out << "NA\tNA\tNA\tNA";
+    }
+    out << std::endl;
+}
+
+//! Read workload name -> updates/s from a previous output of this program.
+std::map<std::string,double> read_baseline(const std::string& filename) {
+    std::ifstream in(filename.c_str());
+    if(!in.good()) {
+        throw std::runtime_error("could not open baseline " + filename);
+    }
+    std::map<std::string,double> b;
+    std::string line;
+    std::getline(in, line); // header
+    while(std::getline(in, line)) {
+        std::istringstream ls(line);
+        std::string name;
+        double wall, updates, ups;
+        if(ls >> name >> wall >> updates >> ups) {
+            b[name] = ups;
+        }
+    }
+    return b;
+}
+
+int main(int argc, const char* argv[]) {
+    std::string bindir=".", wfile="bench/workloads.txt", ofile, bfile, filter;
+    double tolerance=0.10;
+    int repeat=1;
+
+    for(int i=1; i<argc; ++i) {
+        std::string a=argv[i];
+        if(i+1 >= argc) {
+            std::cerr << "missing value for " << a << std::endl;
+            return -1;
+        } else if(a == "--bin") {
+            bindir = argv[++i];
+        } else if(a == "--workloads") {
+            wfile = argv[++i];
+        } else if(a == "--output") {
+            ofile = argv[++i];
+        } else if(a == "--baseline") {
+            bfile = argv[++i];
+        } else if(a == "--tolerance") {
+            tolerance = std::atof(argv[++i]);
+        } else if(a == "--repeat") {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        } else if(a == "--filter") {
+            filter = argv[++i];
+        } else {
+            std::cerr << "unknown option " << a << std::endl;
+            return -1;
+        }
+    }
+
+    try {
+        std::vector<workload> workloads=read_workloads(wfile, filter);
+        std::map<std::string,double> baseline;
+        if(!bfile.empty()) {
+            baseline = read_baseline(bfile);
+        }
+
+        std::ofstream fout;
+        if(!ofile.empty()) {
+            fout.open(ofile.c_str());
+        }
+        std::ostream& out = ofile.empty() ? std::cout : fout;
+        write_header(out);
+
+        int regressions=0;
+        for(std::size_t i=0; i<workloads.size(); ++i) {
+            // keep the fastest of the repeats, which is least disturbed by noise:
+            result best=run(workloads[i], bindir);
+            for(int j=1; j<repeat; ++j) {
+                result r=run(workloads[i], bindir);
+                if(r.wall < best.wall) {
+                    best = r;
+                }
+            }
+            write_result(workloads[i], best, out);
+
+            std::map<std::string,double>::iterator b=baseline.find(workloads[i].name);
+            if(b != baseline.end()) {
+                double ups=best.updates / best.wall;
+                if(ups < b->second * (1.0 - tolerance)) {
+                    ++regressions;
+                    std::cerr << "SLOWDOWN " << workloads[i].name << ": " << ups
+                    << " updates/s vs. baseline " << b->second << " ("
+                    << std::setprecision(3) << (100.0 * (1.0 - ups / b->second)) << "% slower)" << std::endl;
+                }
+            }
+        }
+
+        if(regressions > 0) {
+            std::cerr << regressions << " workload(s) slower than baseline" << std::endl;
+            return 1;
+        }
+    } catch(std::exception& e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return -1;
+    }
+    return 0;
+}
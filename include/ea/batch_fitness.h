@@ -0,0 +1,245 @@
+/* batch_fitness.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_BATCH_FITNESS_H_
+#define _EA_BATCH_FITNESS_H_
+
+#include <algorithm>
+#include <vector>
+#include <boost/utility/enable_if.hpp>
+#include <ea/meta_data.h>
+
+/* Optional batch interface for fitness functions.
+
+ A fitness function that can score many genomes at once declares the matrix it
+ wants them in, and a batch call operator:
+
+     typedef genome_batch<boost::uint8_t, SITE_MAJOR> batch_type;
+
+     template <typename EA>
+     void evaluate_batch(const batch_type& b, double* f, EA& ea);
+
+ which sets f[i] to the fitness of the i'th genome (row) of b.  The
+ selection::batch_evaluated<> wrapper (see ea/selection/batch_evaluated.h)
+ gathers every individual that has not yet been evaluated into such a matrix
+ and stores the results, before the wrapped selection strategy reads them;
+ fitness functions without a batch_type are evaluated one at a time, as usual.
+
+ Genomes of different lengths are padded with T() to the longest; length(i)
+ is the true length of genome i.  Each batch is also stamped with the update
+ in which it was made and the index of its first genome among all those
+ batch-evaluated by its EA during that update, so that a stochastic fitness
+ function can key a random number stream (see ea/counter_rng.h) to each
+ genome however, and wherever, the batch is split up for evaluation.
+ */
+
+namespace ealib {
+
+    //! Layout of the genomes in a genome_batch.
+    enum batch_layout {
+        POPULATION_MAJOR, //!< Each genome is contiguous.
+        SITE_MAJOR //!< Each site, across all genomes, is contiguous.
+    };
+
+    /*! A matrix of n genomes of (at most) l sites each, stored contiguously in
+     the given layout.
+     */
+    template <typename T, batch_layout Layout>
+    class genome_batch {
+    public:
+        typedef T value_type;
+        static const batch_layout layout=Layout;
+
+        //! Constructor.
+        genome_batch() : _n(0), _l(0), _update(0), _first(0) {
+        }
+
+        //! Resize to n genomes of l sites, zero-filled.
+        void resize(std::size_t n, std::size_t l) {
+            _n = n;
+            _l = l;
+            _data.assign(n * l, T());
+            _lengths.assign(n, l);
+        }
+
+        //! Returns the number of genomes.
+        std::size_t size() const {
+            return _n;
+        }
+
+        //! Returns the number of sites per genome, including padding.
+        std::size_t length() const {
+            return _l;
+        }
+
+        //! Returns the number of sites in genome i, excluding padding.
+        std::size_t length(std::size_t i) const {
+            return _lengths[i];
+        }
+
+        //! Returns site j of genome i.
+        T& operator()(std::size_t i, std::size_t j) {
+            return _data[index(i,j)];
+        }
+
+        //! Returns site j of genome i.
+        const T& operator()(std::size_t i, std::size_t j) const {
+            return _data[index(i,j)];
+        }
+
+        /*! Returns a pointer to the contiguous vector of this matrix: genome i
+         if population-major, or site i (of all genomes) if site-major.
+         */
+        const T* vector(std::size_t i) const {
+            return &_data[i * ((Layout == POPULATION_MAJOR) ? _l : _n)];
+        }
+
+        //! Returns a pointer to the whole matrix.
+        T* data() {
+            return _data.empty() ? 0 : &_data[0];
+        }
+
+        //! Returns a pointer to the whole matrix.
+        const T* data() const {
+            return _data.empty() ? 0 : &_data[0];
+        }
+
+        //! Copy the sites in [f,l) into genome i, which must have room for them.
+        template <typename InputIterator>
+        void set_genome(std::size_t i, InputIterator f, InputIterator l) {
+            std::size_t j=0;
+            for( ; f!=l; ++f, ++j) {
+                _data[index(i,j)] = static_cast<T>(*f);
+            }
+            _lengths[i] = j;
+        }
+
+        //! Set the length of genome i.
+        void set_length(std::size_t i, std::size_t l) {
+            _lengths[i] = l;
+        }
+
+        //! Stamp this batch with the update it was made in, and the index of its first genome.
+        void stamp(unsigned long update, std::size_t first) {
+            _update = update;
+            _first = first;
+        }
+
+        //! Returns the update this batch was made in.
+        unsigned long update() const {
+            return _update;
+        }
+
+        //! Returns the index of the first genome of this batch within its update.
+        std::size_t first() const {
+            return _first;
+        }
+
+    protected:
+        std::size_t index(std::size_t i, std::size_t j) const {
+            return (Layout == POPULATION_MAJOR) ? (i * _l + j) : (j * _n + i);
+        }
+
+        std::vector<T> _data; //!< Matrix.
+        std::vector<std::size_t> _lengths; //!< True length of each genome.
+        std::size_t _n; //!< Number of genomes.
+        std::size_t _l; //!< Sites per genome, including padding.
+        unsigned long _update; //!< Update this batch was made in.
+        std::size_t _first; //!< Index of the first genome within its update.
+    };
+
+    //! Detects whether fitness function FF provides the batch interface.
+    template <typename FF>
+    struct has_batch_evaluation {
+        typedef char yes;
+        typedef long no;
+
+        template <typename U>
+        static yes test(typename U::batch_type*);
+
+        template <typename U>
+        static no test(...);
+
+        enum { value = (sizeof(test<FF>(0)) == sizeof(yes)) };
+    };
+
+    LIBEA_MD_DECL(BATCH_UPDATE, "ea.fitness_function.batch.update", unsigned long);
+    LIBEA_MD_DECL(BATCH_STAMPED, "ea.fitness_function.batch.stamped", std::size_t);
+
+    namespace detail {
+
+        /*! Reserve the next n indices of the genomes batch-evaluated during
+         ea's current update, returning the first.  The count is kept in ea's
+         meta-data, so that each EA (e.g., each island) numbers its own genomes.
+         */
+        template <typename EA>
+        std::size_t reserve_batch_indices(std::size_t n, EA& ea) {
+            unsigned long u=ea.current_update();
+            std::size_t first=0;
+            if(get<BATCH_UPDATE>(ea, u+1) == u) {
+                first = get<BATCH_STAMPED>(ea, 0);
+            }
+            put<BATCH_UPDATE>(u, ea);
+            put<BATCH_STAMPED>(first + n, ea);
+            return first;
+        }
+
+        /*! Evaluate, as a single batch, every individual in [f,l) whose fitness
+         is null.
+         */
+        template <typename ForwardIterator, typename EA>
+        typename boost::enable_if_c<has_batch_evaluation<typename EA::fitness_function_type>::value>::type
+        evaluate_batch(ForwardIterator f, ForwardIterator l, EA& ea) {
+            typedef typename EA::fitness_function_type::batch_type batch_type;
+            std::vector<ForwardIterator> pending;
+            std::size_t len=0;
+            for( ; f!=l; ++f) {
+                if((*f)->fitness().is_null()) {
+                    pending.push_back(f);
+                    len = std::max<std::size_t>(len, (*f)->repr().size());
+                }
+            }
+            if(pending.empty()) {
+                return;
+            }
+
+            batch_type b;
+            b.resize(pending.size(), len);
+            for(std::size_t i=0; i<pending.size(); ++i) {
+                b.set_genome(i, (*pending[i])->repr().begin(), (*pending[i])->repr().end());
+            }
+            b.stamp(ea.current_update(), reserve_batch_indices(pending.size(), ea));
+
+            std::vector<double> fit(pending.size());
+            ea.fitness_function().evaluate_batch(b, &fit[0], ea);
+            for(std::size_t i=0; i<pending.size(); ++i) {
+                (*pending[i])->fitness() = fit[i];
+            }
+        }
+
+        //! Fitness functions without a batch interface are evaluated lazily, as usual.
+        template <typename ForwardIterator, typename EA>
+        typename boost::disable_if_c<has_batch_evaluation<typename EA::fitness_function_type>::value>::type
+        evaluate_batch(ForwardIterator f, ForwardIterator l, EA& ea) {
+        }
+
+    } // detail
+} // ealib
+
+#endif
@@ -0,0 +1,209 @@
+/* counter_rng.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_COUNTER_RNG_H_
+#define _EA_COUNTER_RNG_H_
+
+#include <limits>
+#include <boost/cstdint.hpp>
+
+namespace ealib {
+
+    /*! The Philox4x32-10 counter-based random number generator (Salmon et al.,
+     "Parallel random numbers: as easy as 1, 2, 3", SC'11).
+
+     Each 128-bit counter is mapped to 128 random bits by ten rounds of a keyed
+     bijection, so the generator has no state beyond its key and counter: any
+     block of any stream can be computed directly, and streams keyed by, e.g.,
+     (seed, update, individual) can be used from any thread without sharing.
+     */
+    struct philox4x32 {
+        typedef boost::uint32_t word;
+
+        //! Returns the high and low halves of a*b.
+        static void mulhilo(word a, word b, word& hi, word& lo) {
+            boost::uint64_t p=static_cast<boost::uint64_t>(a) * b;
+            hi = static_cast<word>(p >> 32);
+            lo = static_cast<word>(p);
+        }
+
+        //! Map counter ctr to four random words in out, under key k.
+        static void block(const word ctr[4], const word k[2], word out[4]) {
+            word c[4]={ctr[0], ctr[1], ctr[2], ctr[3]};
+            word key[2]={k[0], k[1]};
+            for(int r=0; r<10; ++r) {
+                word hi0, lo0, hi1, lo1;
+                mulhilo(0xD2511F53u, c[0], hi0, lo0);
+                mulhilo(0xCD9E8D57u, c[2], hi1, lo1);
+                c[0] = hi1 ^ c[1] ^ key[0];
+                c[1] = lo1;
+                c[2] = hi0 ^ c[3] ^ key[1];
+                c[3] = lo0;
+                key[0] += 0x9E3779B9u;
+                key[1] += 0xBB67AE85u;
+            }
+            out[0] = c[0];
+            out[1] = c[1];
+            out[2] = c[2];
+            out[3] = c[3];
+        }
+    };
+
+    /*! A stream of random numbers drawn from Philox4x32-10.
+
+     A stream is identified by a seed and a pair of 32-bit stream ids, typically
+     the current update and the index of an individual or evaluation; it is
+     reproducible from those alone.  Random bits are generated 128 at a time and
+     handed out 64 (bits64), or one (bit), at a time, and uniform doubles can be
+     filled in blocks.
+
+     This class also models a Boost.Random uniform random number generator, and
+     so can be used with the Boost distributions.
+     */
+    class counter_rng {
+    public:
+        typedef boost::uint32_t result_type;
+
+        //! Constructor; selects stream (s0, s1) of the given seed.
+        counter_rng(boost::uint64_t seed, boost::uint32_t s0=0, boost::uint32_t s1=0) : _n(0), _nbits(0) {
+            _key[0] = static_cast<boost::uint32_t>(seed);
+            _key[1] = static_cast<boost::uint32_t>(seed >> 32);
+            _ctr[0] = 0;
+            _ctr[1] = 0;
+            _ctr[2] = s0;
+            _ctr[3] = s1;
+            _next = 4;
+        }
+
+        static result_type min BOOST_PREVENT_MACRO_SUBSTITUTION () {
+            return 0;
+        }
+
+        static result_type max BOOST_PREVENT_MACRO_SUBSTITUTION () {
+            return std::numeric_limits<result_type>::max();
+        }
+
+        //! Returns 32 random bits.
+        result_type operator()() {
+            if(_next == 4) {
+                refill();
+            }
+            return _out[_next++];
+        }
+
+        //! Returns 64 random bits.
+        boost::uint64_t bits64() {
+            boost::uint64_t hi=(*this)();
+            return (hi << 32) | (*this)();
+        }
+
+        //! Returns a single random bit.
+        int bit() {
+            if(_nbits == 0) {
+                _bits = bits64();
+                _nbits = 64;
+            }
+            int b=static_cast<int>(_bits & 1);
+            _bits >>= 1;
+            --_nbits;
+            return b;
+        }
+
+        //! Returns a seed for another generator, drawn from this stream.
+        unsigned int seed() {
+            return (*this)();
+        }
+
+        //! Returns a uniform double in [0,1), with 53 random bits.
+        double uniform_real() {
+            return (bits64() >> 11) * (1.0 / 9007199254740992.0);
+        }
+
+        //! Returns a uniform double in [min, max).
+        double uniform_real(double min, double max) {
+            return min + (max - min) * uniform_real();
+        }
+
+        //! Fill [f, f+n) with random words, four at a time where possible.
+        void fill(result_type* f, std::size_t n) {
+            for( ; n>0 && _next<4; --n) {
+                *f++ = _out[_next++];
+            }
+            for( ; n>=4; n-=4, f+=4) {
+                _ctr[0] = static_cast<boost::uint32_t>(_n);
+                _ctr[1] = static_cast<boost::uint32_t>(_n >> 32);
+                philox4x32::block(_ctr, _key, f);
+                ++_n;
+            }
+            for( ; n>0; --n) {
+                *f++ = (*this)();
+            }
+        }
+
+        //! Fill [f, f+n) with uniform doubles in [0,1).
+        void fill_uniform(double* f, std::size_t n) {
+            for(std::size_t i=0; i<n; ++i) {
+                f[i] = uniform_real();
+            }
+        }
+
+        //! Returns a uniform integer in [min, max).
+        template <typename T>
+        T uniform_integer(T min, T max) {
+            boost::uint64_t range=static_cast<boost::uint64_t>(max - min);
+            if(range <= 0xffffffffu) {
+                // multiply-shift; the bias is < range/2^32, which is negligible
+                // for the ranges an EA draws from:
+                return min + static_cast<T>((static_cast<boost::uint64_t>((*this)()) * range) >> 32);
+            }
+            return min + static_cast<T>(bits64() % range);
+        }
+
+        //! Returns true with probability prob.
+        bool p(double prob) {
+            return uniform_real() < prob;
+        }
+
+        //! Returns the number of 128-bit blocks generated so far.
+        boost::uint64_t blocks() const {
+            return _n;
+        }
+
+    protected:
+        //! Generate the next block of this stream.
+        void refill() {
+            _ctr[0] = static_cast<boost::uint32_t>(_n);
+            _ctr[1] = static_cast<boost::uint32_t>(_n >> 32);
+            philox4x32::block(_ctr, _key, _out);
+            ++_n;
+            _next = 0;
+        }
+
+        boost::uint32_t _key[2]; //!< Key (the seed).
+        boost::uint32_t _ctr[4]; //!< Counter: block number, then stream ids.
+        boost::uint32_t _out[4]; //!< Current block.
+        std::size_t _next; //!< Next unused word of the current block.
+        boost::uint64_t _n; //!< Number of blocks generated.
+        boost::uint64_t _bits; //!< Buffered bits for bit().
+        int _nbits; //!< Number of buffered bits.
+    };
+
+} // ealib
+
+#endif
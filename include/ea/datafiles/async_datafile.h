@@ -0,0 +1,364 @@
+/* async_datafile.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_DATAFILES_ASYNC_DATAFILE_H_
+#define _EA_DATAFILES_ASYNC_DATAFILE_H_
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <boost/cstdint.hpp>
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/is_floating_point.hpp>
+#include <boost/utility/enable_if.hpp>
+#include <ea/meta_data.h>
+#include <ea/memory_accounting.h>
+#include <ea/ring_buffer.h>
+
+namespace ealib {
+
+    LIBEA_MD_DECL(DATAFILE_BINARY, "ea.statistics.datafile.binary", bool);
+
+    /*! A single value in a datafile row.
+     */
+    struct datafile_cell {
+        enum type_t { INTEGER=0, REAL=1 };
+
+        boost::uint8_t type;
+        union {
+            boost::int64_t i;
+            double r;
+        } value;
+    };
+
+    /*! A row of a datafile, as passed from the update loop to the writer thread.
+
+     Rows are fixed-size so that they can be stored directly in the ring buffer
+     without any dynamic allocation on the producer side.
+     */
+    struct datafile_row {
+        enum { MAX_FIELDS=32 };
+
+        datafile_row() : n(0) {
+        }
+
+        std::size_t n;
+        datafile_cell cells[MAX_FIELDS];
+    };
+
+    /*! Datafile that moves formatting and I/O off of the update loop.
+
+     The interface mirrors that of ealib::datafile: fields are declared with
+     add_field(), values are appended with write(), and endl() terminates a row.
+     Completed rows are pushed into a lock-free ring buffer, and a dedicated
+     writer thread drains that buffer into a plain-text file.  If the ring buffer
+     is full, the producer yields until the writer catches up; rows are never
+     dropped.
+
+     Optionally, the writer thread also produces a typed, binary columnar file
+     (filename + ".col").  That file is organized as follows, all integers being
+     little-endian:
+
+         header: "EACF" u32(version) u32(ncolumns) {u8(type) u32(len) name}*
+         block:  u32(nrows) {u32(nbytes) bytes}*     (one entry per column)
+
+     Within a block, each column is compressed independently.  Integer columns
+     are delta-encoded and stored as zig-zag varints.  Real columns are XORed
+     with the previous value's bit pattern, and only the bytes between the
+     leading and trailing zero bytes of the result are stored, after a header
+     byte: 0 if the value is unchanged, and otherwise 0x80 | (leading << 3) |
+     trailing.  Unchanged values thus take one byte, and values that differ
+     only in their high bits, such as whole numbers stored as reals, take two
+     or three.
+
+     The columns and their types are fixed by the first row.  A later row with
+     fewer values is padded with zeros in the columnar file, and any values
+     beyond the first row's are written only to the text file.
+     */
+    class async_datafile : boost::noncopyable {
+    public:
+        enum { RING_CAPACITY=1024, BLOCK_ROWS=4096 };
+
+        //! Constructor.
+        async_datafile(const std::string& filename, bool binary=false)
+        : _filename(filename), _binary(binary), _done(false), _header(false) {
+            LIBEA_MEMORY_SCOPE(memory::DATAFILES);
+            _ring.reset(new spsc_ring_buffer<datafile_row>(RING_CAPACITY));
+            _text.open(filename.c_str());
+            if(!_text.good()) {
+                throw std::runtime_error("async_datafile: could not open " + filename);
+            }
+            if(_binary) {
+                _col.open((filename + ".col").c_str(), std::ios::binary);
+                if(!_col.good()) {
+                    throw std::runtime_error("async_datafile: could not open " + filename + ".col");
+                }
+            }
+            _thread.reset(new boost::thread(boost::bind(&async_datafile::run, this)));
+        }
+
+        //! Destructor; drains all pending rows before returning.
+        virtual ~async_datafile() {
+            if(_row.n > 0) {
+                endl();
+            }
+            _done.store(true, boost::memory_order_release);
+            _thread->join();
+        }
+
+        //! Add a field (column) to this datafile.
+        async_datafile& add_field(const std::string& name) {
+            if(_fields.size() >= datafile_row::MAX_FIELDS) {
+                throw std::out_of_range("async_datafile: too many fields in " + _filename);
+            }
+            _fields.push_back(name);
+            return *this;
+        }
+
+        //! Append an integral value to the current row.
+        template <typename T>
+        typename boost::enable_if<boost::is_integral<T>, async_datafile&>::type write(T t) {
+            datafile_cell& c=next_cell();
+            c.type = datafile_cell::INTEGER;
+            c.value.i = static_cast<boost::int64_t>(t);
+            return *this;
+        }
+
+        //! Append a floating-point value to the current row.
+        template <typename T>
+        typename boost::enable_if<boost::is_floating_point<T>, async_datafile&>::type write(T t) {
+            datafile_cell& c=next_cell();
+            c.type = datafile_cell::REAL;
+            c.value.r = static_cast<double>(t);
+            return *this;
+        }
+
+        //! Terminate the current row and hand it off to the writer thread.
+        async_datafile& endl() {
+            while(!_ring->push(_row)) {
+                boost::this_thread::yield();
+            }
+            _row.n = 0;
+            return *this;
+        }
+
+    protected:
+        //! Returns the next cell in the current row.
+        datafile_cell& next_cell() {
+            if(_row.n >= datafile_row::MAX_FIELDS) {
+                throw std::out_of_range("async_datafile: too many values in row of " + _filename);
+            }
+            return _row.cells[_row.n++];
+        }
+
+        //! Writer thread main loop.
+        void run() {
+            LIBEA_MEMORY_SCOPE(memory::DATAFILES);
+            datafile_row r;
+            for( ; ; ) {
+                if(_ring->pop(r)) {
+                    emit(r);
+                } else if(_done.load(boost::memory_order_acquire)) {
+                    while(_ring->pop(r)) {
+                        emit(r);
+                    }
+                    break;
+                } else {
+                    boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+                }
+            }
+            if(_binary) {
+                flush_block();
+            }
+            _text.flush();
+        }
+
+        //! Write row r to the text (and, if enabled, binary) file.
+        void emit(const datafile_row& r) {
+            if(!_header) {
+                write_text_header();
+            }
+            for(std::size_t i=0; i<r.n; ++i) {
+                if(i > 0) {
+                    _text << " ";
+                }
+                if(r.cells[i].type == datafile_cell::INTEGER) {
+                    _text << r.cells[i].value.i;
+                } else {
+                    _text << r.cells[i].value.r;
+                }
+            }
+            _text << "\n";
+
+            if(_binary) {
+                if(_columns.empty()) {
+                    write_binary_header(r);
+                }
+                for(std::size_t i=0; i<_columns.size(); ++i) {
+                    _block.push_back(column_cell(r, i));
+                }
+                if(_block.size() >= (BLOCK_ROWS * _columns.size())) {
+                    flush_block();
+                }
+            }
+        }
+
+        /*! Returns the value of row r in column i, as that column's type, or
+         zero if r is too short.
+         */
+        datafile_cell column_cell(const datafile_row& r, std::size_t i) const {
+            datafile_cell c;
+            c.type = _columns[i];
+            if(c.type == datafile_cell::INTEGER) {
+                c.value.i = 0;
+                if(i < r.n) {
+                    c.value.i = (r.cells[i].type == datafile_cell::INTEGER) ? r.cells[i].value.i : static_cast<boost::int64_t>(r.cells[i].value.r);
+                }
+            } else {
+                c.value.r = 0.0;
+                if(i < r.n) {
+                    c.value.r = (r.cells[i].type == datafile_cell::REAL) ? r.cells[i].value.r : static_cast<double>(r.cells[i].value.i);
+                }
+            }
+            return c;
+        }
+
+        //! Write the names of all fields as the first line of the text file.
+        void write_text_header() {
+            for(std::size_t i=0; i<_fields.size(); ++i) {
+                if(i > 0) {
+                    _text << " ";
+                }
+                _text << _fields[i];
+            }
+            _text << "\n";
+            _header = true;
+        }
+
+        //! Write the columnar file header; column types are taken from row r.
+        void write_binary_header(const datafile_row& r) {
+            _col.write("EACF", 4);
+            put_u32(2, _col);
+            put_u32(static_cast<boost::uint32_t>(r.n), _col);
+            for(std::size_t i=0; i<r.n; ++i) {
+                std::string name = (i < _fields.size()) ? _fields[i] : std::string();
+                _col.put(static_cast<char>(r.cells[i].type));
+                put_u32(static_cast<boost::uint32_t>(name.size()), _col);
+                _col.write(name.data(), name.size());
+                _columns.push_back(r.cells[i].type);
+            }
+        }
+
+        //! Compress and write the current block of rows to the columnar file.
+        void flush_block() {
+            if(_block.empty()) {
+                return;
+            }
+            std::size_t ncols=_columns.size();
+            std::size_t nrows=_block.size() / ncols;
+            put_u32(static_cast<boost::uint32_t>(nrows), _col);
+            for(std::size_t c=0; c<ncols; ++c) {
+                _buf.clear();
+                boost::uint64_t prev=0;
+                for(std::size_t j=0; j<nrows; ++j) {
+                    const datafile_cell& cell=_block[j*ncols + c];
+                    boost::uint64_t bits;
+                    if(_columns[c] == datafile_cell::INTEGER) {
+                        bits = static_cast<boost::uint64_t>(cell.value.i);
+                        boost::int64_t delta = static_cast<boost::int64_t>(bits - prev);
+                        put_varint((static_cast<boost::uint64_t>(delta) << 1) ^ static_cast<boost::uint64_t>(delta >> 63), _buf);
+                    } else {
+                        std::memcpy(&bits, &cell.value.r, sizeof(bits));
+                        put_xor(bits ^ prev, _buf);
+                    }
+                    prev = bits;
+                }
+                put_u32(static_cast<boost::uint32_t>(_buf.size()), _col);
+                _col.write(&_buf[0], _buf.size());
+            }
+            _block.clear();
+        }
+
+        //! Append x to out as a little-endian varint.
+        static void put_varint(boost::uint64_t x, std::vector<char>& out) {
+            while(x >= 0x80) {
+                out.push_back(static_cast<char>((x & 0x7f) | 0x80));
+                x >>= 7;
+            }
+            out.push_back(static_cast<char>(x));
+        }
+
+        /*! Append x, the XOR of a real value's bits with those of the previous
+         value, to out: a header byte giving the number of leading and trailing
+         zero bytes of x, followed by the bytes between them, high to low.
+         */
+        static void put_xor(boost::uint64_t x, std::vector<char>& out) {
+            if(x == 0) {
+                out.push_back(0);
+                return;
+            }
+            int lead=0, trail=0;
+            while(((x >> (56 - 8*lead)) & 0xff) == 0) {
+                ++lead;
+            }
+            while(((x >> (8*trail)) & 0xff) == 0) {
+                ++trail;
+            }
+            out.push_back(static_cast<char>(0x80 | (lead << 3) | trail));
+            for(int b=7-lead; b>=trail; --b) {
+                out.push_back(static_cast<char>((x >> (8*b)) & 0xff));
+            }
+        }
+
+        //! Write x to out as a little-endian 32-bit integer.
+        static void put_u32(boost::uint32_t x, std::ostream& out) {
+            char b[4] = {
+                static_cast<char>(x & 0xff), static_cast<char>((x >> 8) & 0xff),
+                static_cast<char>((x >> 16) & 0xff), static_cast<char>((x >> 24) & 0xff) };
+            out.write(b, 4);
+        }
+
+        std::string _filename; //!< Name of the text file.
+        bool _binary; //!< Whether the columnar file is also written.
+        std::vector<std::string> _fields; //!< Field names.
+        datafile_row _row; //!< Row currently being filled by the producer.
+
+        boost::atomic<bool> _done; //!< Set when the producer is finished.
+        boost::scoped_ptr<spsc_ring_buffer<datafile_row> > _ring; //!< Rows waiting to be written.
+        boost::scoped_ptr<boost::thread> _thread; //!< Writer thread.
+
+        // the following are only touched by the writer thread:
+        bool _header; //!< Whether the text header has been written.
+        std::ofstream _text; //!< Text output.
+        std::ofstream _col; //!< Columnar output.
+        std::vector<boost::uint8_t> _columns; //!< Column types.
+        std::vector<datafile_cell> _block; //!< Cells of the current block, row-major.
+        std::vector<char> _buf; //!< Scratch space for column encoding.
+    };
+
+} // ealib
+
+#endif
@@ -0,0 +1,70 @@
+/* async_fitness.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_DATAFILES_ASYNC_FITNESS_H_
+#define _EA_DATAFILES_ASYNC_FITNESS_H_
+
+#include <boost/accumulators/accumulators.hpp>
+#include <boost/accumulators/statistics.hpp>
+#include <ea/events.h>
+#include <ea/datafiles/async_datafile.h>
+
+namespace ealib {
+    namespace datafiles {
+
+        /*! Drop-in replacement for datafiles::fitness that writes through an
+         async_datafile.
+
+         The update loop only calculates the statistics and enqueues a row; text
+         formatting, I/O, and (if DATAFILE_BINARY is set) columnar encoding all
+         happen on the writer thread.
+         */
+        template <typename EA>
+        struct async_fitness : record_statistics_event<EA> {
+            async_fitness(EA& ea)
+            : record_statistics_event<EA>(ea), _df("fitness.dat", get<DATAFILE_BINARY>(ea,false)) {
+                _df.add_field("update")
+                .add_field("mean_fitness")
+                .add_field("max_fitness");
+            }
+
+            virtual ~async_fitness() {
+            }
+
+            virtual void operator()(EA& ea) {
+                using namespace boost::accumulators;
+                accumulator_set<double, stats<tag::mean, tag::max> > fit;
+
+                for(typename EA::population_type::iterator i=ea.population().begin(); i!=ea.population().end(); ++i) {
+                    fit(static_cast<double>(ealib::fitness(**i,ea)));
+                }
+
+                _df.write(ea.current_update())
+                .write(mean(fit))
+                .write(max(fit))
+                .endl();
+            }
+
+            async_datafile _df;
+        };
+
+    } // datafiles
+} // ealib
+
+#endif
@@ -0,0 +1,79 @@
+/* async_meta_population_fitness.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_DATAFILES_ASYNC_META_POPULATION_FITNESS_H_
+#define _EA_DATAFILES_ASYNC_META_POPULATION_FITNESS_H_
+
+#include <boost/accumulators/accumulators.hpp>
+#include <boost/accumulators/statistics.hpp>
+#include <ea/events.h>
+#include <ea/datafiles/async_datafile.h>
+
+namespace ealib {
+    namespace datafiles {
+
+        namespace detail {
+
+            //! Add the fitness of every individual of island to acc.
+            template <typename Island, typename Accumulator>
+            void island_fitness(Island& island, Accumulator& acc) {
+                for(typename Island::population_type::iterator i=island.population().begin(); i!=island.population().end(); ++i) {
+                    acc(static_cast<double>(ealib::fitness(**i, island)));
+                }
+            }
+
+        } // detail
+
+        /*! Drop-in replacement for datafiles::meta_population_fitness that writes
+         through an async_datafile: the mean and maximum fitness over every
+         individual of every island.
+         */
+        template <typename EA>
+        struct async_meta_population_fitness : record_statistics_event<EA> {
+            async_meta_population_fitness(EA& ea)
+            : record_statistics_event<EA>(ea), _df("meta_population_fitness.dat", get<DATAFILE_BINARY>(ea,false)) {
+                _df.add_field("update")
+                .add_field("mean_fitness")
+                .add_field("max_fitness");
+            }
+
+            virtual ~async_meta_population_fitness() {
+            }
+
+            virtual void operator()(EA& ea) {
+                using namespace boost::accumulators;
+                accumulator_set<double, stats<tag::mean, tag::max> > fit;
+
+                for(typename EA::population_type::iterator i=ea.population().begin(); i!=ea.population().end(); ++i) {
+                    detail::island_fitness(**i, fit);
+                }
+
+                _df.write(ea.current_update())
+                .write(mean(fit))
+                .write(max(fit))
+                .endl();
+            }
+
+            async_datafile _df;
+        };
+
+    } // datafiles
+} // ealib
+
+#endif
@@ -0,0 +1,76 @@
+/* async_qhfc.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_DATAFILES_ASYNC_QHFC_H_
+#define _EA_DATAFILES_ASYNC_QHFC_H_
+
+#include <boost/accumulators/accumulators.hpp>
+#include <boost/accumulators/statistics.hpp>
+#include <ea/events.h>
+#include <ea/datafiles/async_datafile.h>
+#include <ea/datafiles/async_meta_population_fitness.h>
+
+namespace ealib {
+    namespace datafiles {
+
+        /*! Replacement for datafiles::qhfc that writes through an async_datafile.
+
+         Each recording period, one row is written to "qhfc.dat" for each island
+         (fitness level) of a QHFC meta-population: the update, the island's
+         index, and the minimum, mean, and maximum fitness of its individuals.
+         Rows are per island, rather than columns, so that the number of
+         islands is not limited by the number of fields in a row.
+         */
+        template <typename EA>
+        struct async_qhfc : record_statistics_event<EA> {
+            async_qhfc(EA& ea)
+            : record_statistics_event<EA>(ea), _df("qhfc.dat", get<DATAFILE_BINARY>(ea,false)) {
+                _df.add_field("update")
+                .add_field("island")
+                .add_field("min_fitness")
+                .add_field("mean_fitness")
+                .add_field("max_fitness");
+            }
+
+            virtual ~async_qhfc() {
+            }
+
+            virtual void operator()(EA& ea) {
+                using namespace boost::accumulators;
+                std::size_t k=0;
+                for(typename EA::population_type::iterator i=ea.population().begin(); i!=ea.population().end(); ++i, ++k) {
+                    accumulator_set<double, stats<tag::min, tag::mean, tag::max> > fit;
+                    detail::island_fitness(**i, fit);
+
+                    _df.write(ea.current_update())
+                    .write(k)
+                    .write(min(fit))
+                    .write(mean(fit))
+                    .write(max(fit))
+                    .endl();
+                }
+            }
+
+            async_datafile _df;
+        };
+
+    } // datafiles
+} // ealib
+
+#endif
@@ -0,0 +1,69 @@
+/* fitness_cache.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_DATAFILES_FITNESS_CACHE_H_
+#define _EA_DATAFILES_FITNESS_CACHE_H_
+
+#include <ea/events.h>
+#include <ea/datafile.h>
+#include <ea/fitness_functions/memoized.h>
+
+namespace ealib {
+    namespace datafiles {
+
+        /*! Writes the hit rate of memoized fitness functions to
+         "fitness_cache.dat" each recording period.  Hits and misses are counted
+         since the previous row; entries is the current size of all caches.
+         */
+        template <typename EA>
+        struct fitness_cache : record_statistics_event<EA> {
+            fitness_cache(EA& ea) : record_statistics_event<EA>(ea), _df("fitness_cache.dat"), _hits(0), _misses(0) {
+                _df.add_field("update")
+                .add_field("hits")
+                .add_field("misses")
+                .add_field("hit_rate")
+                .add_field("entries");
+            }
+
+            virtual ~fitness_cache() {
+            }
+
+            virtual void operator()(EA& ea) {
+                fitness_cache_stats& s=global_cache_stats();
+                boost::uint64_t h=s.hits - _hits, m=s.misses - _misses;
+                _hits = s.hits;
+                _misses = s.misses;
+
+                _df.write(ea.current_update())
+                .write(h)
+                .write(m)
+                .write((h + m) > 0 ? static_cast<double>(h) / (h + m) : 0.0)
+                .write(s.entries)
+                .endl();
+            }
+
+            datafile _df;
+            boost::uint64_t _hits; //!< Hits as of the previous row.
+            boost::uint64_t _misses; //!< Misses as of the previous row.
+        };
+
+    } // datafiles
+} // ealib
+
+#endif
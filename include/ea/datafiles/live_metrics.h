@@ -0,0 +1,82 @@
+/* live_metrics.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_DATAFILES_LIVE_METRICS_H_
+#define _EA_DATAFILES_LIVE_METRICS_H_
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <boost/lexical_cast.hpp>
+#include <unistd.h>
+#include <ea/events.h>
+#include <ea/meta_data.h>
+#include <ea/live_metrics_ring.h>
+
+namespace ealib {
+
+    LIBEA_MD_DECL(LIVE_METRICS_NAME, "ea.statistics.live_metrics.name", std::string);
+    LIBEA_MD_DECL(LIVE_METRICS_CAPACITY, "ea.statistics.live_metrics.capacity", std::size_t);
+
+    namespace datafiles {
+
+        /*! Publishes fitness statistics for every update into a shared-memory
+         ring, where they can be watched with the live_metrics_reader program.
+
+         Nothing is written to disk.  The segment is named by LIVE_METRICS_NAME,
+         which defaults to "ealib_metrics_<pid>", and holds the most recent
+         LIVE_METRICS_CAPACITY updates (default 1024; must be at least 1).
+         */
+        template <typename EA>
+        struct live_metrics : end_of_update_event<EA> {
+            live_metrics(EA& ea)
+            : end_of_update_event<EA>(ea)
+            , _ring(get<LIVE_METRICS_NAME>(ea, "ealib_metrics_" + boost::lexical_cast<std::string>(getpid())),
+                    get<LIVE_METRICS_CAPACITY>(ea, 1024)) {
+            }
+
+            virtual ~live_metrics() {
+            }
+
+            virtual void operator()(EA& ea) {
+                metrics_record r;
+                r.update = ea.current_update();
+                r.population_size = ea.population().size();
+                r.min_fitness = std::numeric_limits<double>::max();
+                r.max_fitness = -std::numeric_limits<double>::max();
+
+                double sum=0.0;
+                for(typename EA::population_type::iterator i=ea.population().begin(); i!=ea.population().end(); ++i) {
+                    double f=static_cast<double>(ealib::fitness(**i,ea));
+                    sum += f;
+                    r.min_fitness = std::min(r.min_fitness, f);
+                    r.max_fitness = std::max(r.max_fitness, f);
+                }
+                r.mean_fitness = ea.population().empty() ? 0.0 : sum / ea.population().size();
+
+                _ring.write(r);
+            }
+
+            metrics_ring_writer _ring;
+        };
+
+    } // datafiles
+} // ealib
+
+#endif
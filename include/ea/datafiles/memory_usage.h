@@ -0,0 +1,138 @@
+/* memory_usage.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_DATAFILES_MEMORY_USAGE_H_
+#define _EA_DATAFILES_MEMORY_USAGE_H_
+
+#include <ea/events.h>
+#include <ea/datafile.h>
+#include <ea/memory_accounting.h>
+
+namespace ealib {
+
+    namespace memory {
+
+        /*! Returns an estimate of the bytes held by the genomes in population
+         p: the sum of their capacities.  This counts storage shared between
+         genomes (e.g., the chunks of copy-on-write genomes) once per genome,
+         and leaves out allocator overhead and pooled buffers.
+         */
+        template <typename Population>
+        boost::int64_t estimated_genome_bytes(Population& p) {
+            boost::int64_t b=0;
+            for(typename Population::iterator i=p.begin(); i!=p.end(); ++i) {
+                b += (*i)->repr().capacity() * sizeof(typename Population::value_type::element_type::representation_type::value_type);
+            }
+            return b;
+        }
+
+        /*! Writes one row of memory accounting to df.
+
+         All but the last two columns are the allocator-level counters kept by
+         src/memory_accounting.cpp, and read as zero unless the program is built
+         with LIBEA_MEMORY_ACCOUNTING: the bytes currently held by individuals
+         and their meta-data (offspring_bytes), by genomes (genome_bytes: all
+         chunked_genome storage, plus the growth of other genomes during
+         mutation), and by line-of-descent links (attribute_bytes), the
+         high-water mark of fitness evaluation since the last row
+         (network_peak_bytes), the bytes held by datafiles and by everything
+         else, and their total.  est_genome_bytes and est_rng_bytes are
+         estimates computed from the population, and are not measured.
+         */
+        inline void write_usage(datafile& df, long update, boost::int64_t est_genomes, boost::int64_t est_rng) {
+            df.write(update)
+            .write(live_bytes(OFFSPRING))
+            .write(live_bytes(GENOMES))
+            .write(live_bytes(ATTRIBUTES))
+            .write(peak_bytes(NETWORKS))
+            .write(live_bytes(DATAFILES))
+            .write(live_bytes(OTHER))
+            .write(total_bytes())
+            .write(est_genomes)
+            .write(est_rng)
+            .endl();
+
+            reset_peak(NETWORKS);
+        }
+
+        //! Add the memory accounting fields to df.
+        inline void add_usage_fields(datafile& df) {
+            df.add_field("update")
+            .add_field("offspring_bytes")
+            .add_field("genome_bytes")
+            .add_field("attribute_bytes")
+            .add_field("network_peak_bytes")
+            .add_field("datafile_bytes")
+            .add_field("other_bytes")
+            .add_field("total_bytes")
+            .add_field("est_genome_bytes")
+            .add_field("est_rng_bytes");
+        }
+
+    } // memory
+
+    namespace datafiles {
+
+        /*! Writes memory accounting for a single population to "memory_usage.dat"
+         each recording period; see memory::write_usage.
+         */
+        template <typename EA>
+        struct memory_usage : record_statistics_event<EA> {
+            memory_usage(EA& ea) : record_statistics_event<EA>(ea), _df("memory_usage.dat") {
+                memory::add_usage_fields(_df);
+            }
+
+            virtual ~memory_usage() {
+            }
+
+            virtual void operator()(EA& ea) {
+                memory::write_usage(_df, ea.current_update(), memory::estimated_genome_bytes(ea.population()), sizeof(ea.rng()));
+            }
+
+            datafile _df;
+        };
+
+        /*! Writes memory accounting for a meta-population to "memory_usage.dat";
+         the estimated genome and RNG bytes are summed over all islands.
+         */
+        template <typename EA>
+        struct meta_population_memory_usage : record_statistics_event<EA> {
+            meta_population_memory_usage(EA& ea) : record_statistics_event<EA>(ea), _df("memory_usage.dat") {
+                memory::add_usage_fields(_df);
+            }
+
+            virtual ~meta_population_memory_usage() {
+            }
+
+            virtual void operator()(EA& ea) {
+                boost::int64_t genomes=0, rng=sizeof(ea.rng());
+                for(typename EA::population_type::iterator i=ea.population().begin(); i!=ea.population().end(); ++i) {
+                    genomes += memory::estimated_genome_bytes((*i)->population());
+                    rng += sizeof((*i)->rng());
+                }
+                memory::write_usage(_df, ea.current_update(), genomes, rng);
+            }
+
+            datafile _df;
+        };
+
+    } // datafiles
+} // ealib
+
+#endif
@@ -0,0 +1,93 @@
+/* phase_breakdown.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_DATAFILES_PHASE_BREAKDOWN_H_
+#define _EA_DATAFILES_PHASE_BREAKDOWN_H_
+
+#include <string>
+#include <ea/events.h>
+#include <ea/profiling.h>
+#include <ea/datafiles/async_datafile.h>
+
+namespace ealib {
+    namespace datafiles {
+
+#ifdef LIBEA_PROFILING
+        /*! Writes the ticks spent in, and the number of entries into, each
+         profiled phase during every update to "phase_breakdown.dat", along with
+         the total ticks elapsed since the previous update.  Ticks are exclusive
+         of nested phases (see ea/profiling.h).  Counters are reset
+         after each update.
+         */
+        template <typename EA>
+        struct phase_breakdown : end_of_update_event<EA> {
+            phase_breakdown(EA& ea) : end_of_update_event<EA>(ea), _df("phase_breakdown.dat") {
+                _df.add_field("update")
+                .add_field("update_ticks");
+                for(std::size_t i=0; i<profiling::NPHASES; ++i) {
+                    _df.add_field(std::string(profiling::phase_name(i)) + "_ticks");
+                }
+                for(std::size_t i=0; i<profiling::NPHASES; ++i) {
+                    _df.add_field(std::string(profiling::phase_name(i)) + "_calls");
+                }
+                profiling::global_counters().reset();
+                _last = profiling::ticks();
+            }
+
+            virtual ~phase_breakdown() {
+            }
+
+            virtual void operator()(EA& ea) {
+                profiling::counters& c=profiling::global_counters();
+                boost::uint64_t now=profiling::ticks();
+                _df.write(ea.current_update())
+                .write(now - _last);
+                for(std::size_t i=0; i<profiling::NPHASES; ++i) {
+                    _df.write(c.ticks[i]);
+                }
+                for(std::size_t i=0; i<profiling::NPHASES; ++i) {
+                    _df.write(c.calls[i]);
+                }
+                _df.endl();
+                c.reset();
+                _last = now;
+            }
+
+            async_datafile _df;
+            boost::uint64_t _last; //!< Ticks at the end of the previous update.
+        };
+#else
+        //! Profiling is disabled; this event does nothing.
+        template <typename EA>
+        struct phase_breakdown : end_of_update_event<EA> {
+            phase_breakdown(EA& ea) : end_of_update_event<EA>(ea) {
+            }
+
+            virtual ~phase_breakdown() {
+            }
+
+            virtual void operator()(EA& ea) {
+            }
+        };
+#endif
+
+    } // datafiles
+} // ealib
+
+#endif
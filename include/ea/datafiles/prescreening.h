@@ -0,0 +1,75 @@
+/* prescreening.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_DATAFILES_PRESCREENING_H_
+#define _EA_DATAFILES_PRESCREENING_H_
+
+#include <ea/events.h>
+#include <ea/datafile.h>
+#include <ea/selection/prescreened.h>
+
+namespace ealib {
+    namespace datafiles {
+
+        /*! Writes the accuracy of surrogate pre-screening to "prescreening.dat"
+         each recording period: the number of offspring screened since the
+         previous row, how many were accepted, rejected, and audited, the
+         fraction of audited offspring that beat those accepted alongside them,
+         and the mean absolute error of the surrogate's predictions.
+         */
+        template <typename EA>
+        struct prescreening : record_statistics_event<EA> {
+            prescreening(EA& ea) : record_statistics_event<EA>(ea), _df("prescreening.dat") {
+                _df.add_field("update")
+                .add_field("screened")
+                .add_field("accepted")
+                .add_field("rejected")
+                .add_field("audited")
+                .add_field("false_rejection_rate")
+                .add_field("mean_abs_error");
+            }
+
+            virtual ~prescreening() {
+            }
+
+            virtual void operator()(EA& ea) {
+                prescreen_stats& s=global_prescreen_stats();
+                boost::uint64_t audited=s.audited - _last.audited;
+                boost::uint64_t errors=s.errors - _last.errors;
+
+                _df.write(ea.current_update())
+                .write(s.screened - _last.screened)
+                .write(s.accepted - _last.accepted)
+                .write(s.rejected - _last.rejected)
+                .write(audited)
+                .write(audited > 0 ? static_cast<double>(s.false_rejections - _last.false_rejections) / audited : 0.0)
+                .write(errors > 0 ? (s.abs_error - _last.abs_error) / errors : 0.0)
+                .endl();
+
+                _last = s;
+            }
+
+            datafile _df;
+            prescreen_stats _last; //!< Statistics as of the previous row.
+        };
+
+    } // datafiles
+} // ealib
+
+#endif
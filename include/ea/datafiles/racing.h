@@ -0,0 +1,71 @@
+/* racing.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_DATAFILES_RACING_H_
+#define _EA_DATAFILES_RACING_H_
+
+#include <ea/events.h>
+#include <ea/datafile.h>
+#include <ea/fitness_functions/racing.h>
+
+namespace ealib {
+    namespace datafiles {
+
+        /*! Writes the outcome of fitness races to "racing.dat" each recording
+         period: the number of races since the previous row, how many were
+         aborted or extended, the mean number of trials per race, and the
+         current threshold.
+         */
+        template <typename EA>
+        struct racing : record_statistics_event<EA> {
+            racing(EA& ea) : record_statistics_event<EA>(ea), _df("racing.dat") {
+                _df.add_field("update")
+                .add_field("races")
+                .add_field("aborted")
+                .add_field("extended")
+                .add_field("mean_trials")
+                .add_field("threshold");
+            }
+
+            virtual ~racing() {
+            }
+
+            virtual void operator()(EA& ea) {
+                racing_stats& s=global_racing_stats();
+                boost::uint64_t n=s.races - _last.races;
+
+                _df.write(ea.current_update())
+                .write(n)
+                .write(s.aborted - _last.aborted)
+                .write(s.extended - _last.extended)
+                .write(n > 0 ? static_cast<double>(s.trials - _last.trials) / n : 0.0)
+                .write(get<RACING_THRESHOLD>(ea, 0.0))
+                .endl();
+
+                _last = s;
+            }
+
+            datafile _df;
+            racing_stats _last; //!< Statistics as of the previous row.
+        };
+
+    } // datafiles
+} // ealib
+
+#endif
@@ -0,0 +1,178 @@
+/* mailboxes.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_DIGITAL_EVOLUTION_MAILBOXES_H_
+#define _EA_DIGITAL_EVOLUTION_MAILBOXES_H_
+
+#include <stdexcept>
+#include <string>
+#include <boost/cstdint.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/serialization/nvp.hpp>
+#include <ea/digital_evolution.h>
+#include <ea/meta_data.h>
+#include <ea/mailbox.h>
+
+namespace ealib {
+
+    LIBEA_MD_DECL(MAILBOX_CAPACITY, "ea.mailbox.capacity", unsigned int);
+    LIBEA_MD_DECL(MAILBOX_OVERFLOW, "ea.mailbox.overflow", std::string);
+
+    /*! A message between organisms: a label and a datum, as with tx_msg, and
+     the name of the organism it was sent to.
+     */
+    struct mailbox_message {
+        int label;
+        int data;
+        boost::uint64_t to;
+
+        template <class Archive>
+        void serialize(Archive& ar, const unsigned int version) {
+            ar & boost::serialization::make_nvp("label", label);
+            ar & boost::serialization::make_nvp("data", data);
+            ar & boost::serialization::make_nvp("to", to);
+        }
+    };
+
+    /*! The mailboxes of a digital evolution EA, one per cell of its grid, in
+     row-major order.
+
+     An EA that uses the mailbox instructions derives its configuration from
+     mailbox_configuration, so that the mailboxes belong to that EA, and calls
+     initialize_mailboxes() from its configuration's initialize(), before any
+     organism is run.  After that, the mailboxes may be used from any thread.
+     Messages in flight can be checkpointed along with the configuration.
+     */
+    class mailbox_configuration {
+    public:
+        /*! Create the mailboxes of ea, with MAILBOX_CAPACITY messages each
+         (default 8) and the MAILBOX_OVERFLOW policy (default "drop_newest").
+         */
+        template <typename EA>
+        void initialize_mailboxes(EA& ea) {
+            _mailboxes.reset(new mailbox_array<mailbox_message>(get<SPATIAL_X>(ea) * get<SPATIAL_Y>(ea),
+                                                                get<MAILBOX_CAPACITY>(ea, 8),
+                                                                make_mailbox_overflow(get<MAILBOX_OVERFLOW>(ea, "drop_newest"))));
+        }
+
+        //! Returns the mailboxes.
+        mailbox_array<mailbox_message>& mailboxes() {
+            if(!_mailboxes) {
+                throw std::logic_error("mailboxes used before initialize_mailboxes()");
+            }
+            return *_mailboxes;
+        }
+
+        //! Serialize the mailboxes; they must already have been initialized.
+        template <class Archive>
+        void serialize(Archive& ar, const unsigned int version) {
+            ar & boost::serialization::make_nvp("mailboxes", mailboxes());
+        }
+
+    protected:
+        boost::scoped_ptr<mailbox_array<mailbox_message> > _mailboxes; //!< Mailboxes, one per cell.
+    };
+
+    //! Returns the mailboxes of ea.
+    template <typename EA>
+    mailbox_array<mailbox_message>& mailboxes(EA& ea) {
+        return ea.configuration().mailboxes();
+    }
+
+    namespace detail {
+
+        //! Returns the index of the mailbox of location l.
+        template <typename Location, typename EA>
+        std::size_t mailbox_index(const Location& l, EA& ea) {
+            return l.y * get<SPATIAL_X>(ea) + l.x;
+        }
+
+        /*! Deliver m to the inhabitant of location l.  The mailbox is first
+         claimed for the inhabitant, so that it is cleared of messages left for
+         a previous inhabitant without losing any sent to this one.
+         */
+        template <typename Location, typename EA>
+        void deliver(Location& l, mailbox_message m, EA& ea) {
+            mailbox_array<mailbox_message>& mb=mailboxes(ea);
+            std::size_t i=mailbox_index(l, ea);
+            m.to = static_cast<boost::uint64_t>(l.inhabitant()->name());
+            mb.claim(i, m.to);
+            mb.push(i, m);
+        }
+
+    } // detail
+
+    namespace instructions {
+
+        /*! Send a message to the faced neighbor's mailbox: label ?BX?, data ?CX?.
+         Unlike tx_msg, the message is copied into a fixed slot of the cell's
+         mailbox, and nothing is allocated.
+         */
+        DIGEVO_INSTRUCTION_DECL(tx_mbox) {
+            typename EA::environment_type::location_type& l=*ea.env().neighbor(p);
+            if(l.occupied()) {
+                int rbx=hw.modifyRegister();
+                int rcx=hw.nextRegister(rbx);
+                mailbox_message m={hw.getRegValue(rbx), hw.getRegValue(rcx), 0};
+                detail::deliver(l, m, ea);
+            }
+        }
+
+        /*! Send a message to the mailbox of every occupied neighbor: label ?BX?,
+         data ?CX?.
+         */
+        DIGEVO_INSTRUCTION_DECL(bc_mbox) {
+            typedef typename EA::environment_type::neighborhood_iterator neighborhood_iterator;
+            int rbx=hw.modifyRegister();
+            int rcx=hw.nextRegister(rbx);
+            mailbox_message m={hw.getRegValue(rbx), hw.getRegValue(rcx), 0};
+            std::pair<neighborhood_iterator,neighborhood_iterator> ni=ea.env().neighborhood(p);
+            for( ; ni.first!=ni.second; ++ni.first) {
+                if(ni.first->occupied()) {
+                    detail::deliver(*ni.first, m, ea);
+                }
+            }
+        }
+
+        /*! Receive the oldest message sent to this organism: label into ?BX?,
+         data into ?CX?.  Messages sent to a previous inhabitant of the cell are
+         discarded; if there are no others, the registers are left unchanged.
+         */
+        DIGEVO_INSTRUCTION_DECL(rx_mbox) {
+            mailbox_array<mailbox_message>& mb=mailboxes(ea);
+            std::size_t i=detail::mailbox_index(*ea.env().location(p), ea);
+            boost::uint64_t self=static_cast<boost::uint64_t>(p->name());
+            mb.claim(i, self);
+            mailbox_message m;
+            while(mb.pop(i, m)) {
+                // a sender that saw the previous inhabitant can deliver after the claim:
+                if(m.to == self) {
+                    int rbx=hw.modifyRegister();
+                    int rcx=hw.nextRegister(rbx);
+                    hw.setRegValue(rbx, m.label);
+                    hw.setRegValue(rcx, m.data);
+                    return;
+                }
+            }
+        }
+
+    } // instructions
+} // ealib
+
+#endif
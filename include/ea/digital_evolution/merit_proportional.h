@@ -0,0 +1,114 @@
+/* merit_proportional.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_DIGITAL_EVOLUTION_MERIT_PROPORTIONAL_H_
+#define _EA_DIGITAL_EVOLUTION_MERIT_PROPORTIONAL_H_
+
+#include <algorithm>
+#include <vector>
+#include <ea/meta_data.h>
+#include <ea/fenwick_tree.h>
+#include <ea/profiling.h>
+
+namespace ealib {
+
+    /*! Merit-proportional scheduler for digital evolution.
+
+     Each update, the organisms alive at its start are given, between them,
+     SCHEDULER_TIME_SLICE cycles per organism (the same budget as round-robin),
+     in grants of SCHEDULER_TIME_SLICE cycles.  Each grant goes to an organism
+     drawn in proportion to its priority (its merit), so an organism's expected
+     share of the update's cycles is its share of the population's merit.
+
+     Priorities are kept in a Fenwick tree, which is rebuilt in O(N) at the
+     start of each update.  After each grant, only the organism that ran has its
+     weight updated, since it is the only one whose merit can have changed by
+     executing, so an update costs O(N log N).  Organisms that have died are
+     given zero weight when they are next drawn, and such a draw does not use up
+     a grant; organisms born during an update are first scheduled in the next.
+     If no living organism has any priority left, the rest of the update's
+     grants are given round-robin to the living organisms, in population order.
+
+     Time spent scheduling, but not executing, is charged to the SCHEDULER
+     profiling phase.
+     */
+    struct merit_proportional {
+        //! Execute the organisms in population for one update.
+        template <typename EA>
+        void operator()(typename EA::population_type& population, EA& ea) {
+            typedef typename EA::population_type::value_type individual_ptr_type;
+            std::size_t slice=get<SCHEDULER_TIME_SLICE>(ea);
+            std::vector<individual_ptr_type> orgs(population.begin(), population.end());
+            {
+                LIBEA_PROFILE_SCOPE(profiling::SCHEDULER);
+                _w.resize(orgs.size());
+                for(std::size_t i=0; i<orgs.size(); ++i) {
+                    _w[i] = std::max(0.0, static_cast<double>(orgs[i]->priority()));
+                }
+                _tree.assign(_w.begin(), _w.end());
+            }
+
+            std::size_t n=0; // grants made
+            while(n < orgs.size()) {
+                std::size_t i;
+                {
+                    LIBEA_PROFILE_SCOPE(profiling::SCHEDULER);
+                    double total=_tree.total();
+                    if(total <= 0.0) {
+                        break;
+                    }
+                    i = _tree.find(ea.rng().uniform_real(0.0, total));
+                    if(_tree[i] <= 0.0) {
+                        // round-off left a positive total over zero weights:
+                        _tree.refresh();
+                        continue;
+                    }
+                    if(!orgs[i]->alive()) {
+                        _tree.set(i, 0.0);
+                        continue;
+                    }
+                }
+                orgs[i]->execute(slice, orgs[i], ea);
+                ++n;
+                {
+                    LIBEA_PROFILE_SCOPE(profiling::SCHEDULER);
+                    _tree.set(i, orgs[i]->alive() ? std::max(0.0, static_cast<double>(orgs[i]->priority())) : 0.0);
+                }
+            }
+
+            // no priority left; fall back to round-robin, stopping once a full
+            // pass finds no living organism:
+            for(std::size_t i=0, idle=0; (n < orgs.size()) && (idle < orgs.size()); i=(i+1) % orgs.size()) {
+                if(orgs[i]->alive()) {
+                    orgs[i]->execute(slice, orgs[i], ea);
+                    ++n;
+                    idle = 0;
+                } else {
+                    ++idle;
+                }
+            }
+        }
+
+        std::vector<double> _w; //!< Priorities at the start of the update.
+        fenwick_tree<double> _tree; //!< Current priorities.
+    };
+
+} // ealib
+
+#endif
@@ -0,0 +1,164 @@
+/* fenwick_tree.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_FENWICK_TREE_H_
+#define _EA_FENWICK_TREE_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace ealib {
+
+    /*! Fenwick (binary indexed) tree over a sequence of non-negative weights.
+
+     Supports O(n) construction, O(log n) point updates, appends and prefix
+     sums, and O(log n) weighted sampling via find(), which makes it suitable
+     for fitness-proportionate selection and merit-proportional scheduling
+     where weights change incrementally.
+     */
+    template <typename T>
+    class fenwick_tree {
+    public:
+        typedef T value_type;
+
+        //! Constructor.
+        fenwick_tree() : _mask(0) {
+        }
+
+        //! Constructor; n weights, all zero.
+        fenwick_tree(std::size_t n) {
+            resize(n);
+        }
+
+        //! Reset this tree to n weights, all zero.
+        void resize(std::size_t n) {
+            _w.assign(n, T());
+            resize_index(n);
+        }
+
+        //! Rebuild this tree from the weights in [f,l), in O(n).
+        template <typename ForwardIterator>
+        void assign(ForwardIterator f, ForwardIterator l) {
+            _w.assign(f, l);
+            refresh();
+        }
+
+        /*! Rebuild the tree from the current weights, in O(n), discarding any
+         round-off accumulated by set().
+         */
+        void refresh() {
+            std::size_t n=_w.size();
+            resize_index(n);
+            for(std::size_t i=1; i<=n; ++i) {
+                _t[i] += _w[i-1];
+                std::size_t j=i + (i & (~i + 1));
+                if(j <= n) {
+                    _t[j] += _t[i];
+                }
+            }
+        }
+
+        //! Append weight v, in O(log n).
+        void push_back(const T& v) {
+            std::size_t i=_w.size() + 1; // 1-indexed position of v
+            if(_t.empty()) {
+                _t.push_back(T());
+            }
+            _t.push_back(v + prefix(i-1) - prefix(i - (i & (~i + 1))));
+            _w.push_back(v);
+            if(_mask == 0) {
+                _mask = 1;
+            }
+            while((_mask << 1) <= _w.size()) {
+                _mask <<= 1;
+            }
+        }
+
+        //! Returns the number of weights.
+        std::size_t size() const {
+            return _w.size();
+        }
+
+        //! Returns weight i.
+        const T& operator[](std::size_t i) const {
+            return _w[i];
+        }
+
+        //! Set weight i to v, in O(log n).
+        void set(std::size_t i, const T& v) {
+            T delta=v - _w[i];
+            _w[i] = v;
+            for(std::size_t j=i+1; j<_t.size(); j += (j & (~j + 1))) {
+                _t[j] += delta;
+            }
+        }
+
+        //! Returns the sum of weights [0,i), in O(log n).
+        T prefix(std::size_t i) const {
+            T s=T();
+            for( ; i>0; i -= (i & (~i + 1))) {
+                s += _t[i];
+            }
+            return s;
+        }
+
+        //! Returns the sum of all weights.
+        T total() const {
+            return prefix(_w.size());
+        }
+
+        /*! Returns the smallest index i such that prefix(i+1) > x, in O(log n).
+
+         If x is uniformly distributed in [0,total()), then i is distributed in
+         proportion to the weights.  Returns size() if the tree is empty.
+         */
+        std::size_t find(T x) const {
+            if(_w.empty()) {
+                return _w.size();
+            }
+            std::size_t pos=0;
+            for(std::size_t step=_mask; step>0; step >>= 1) {
+                std::size_t next=pos + step;
+                if(next < _t.size() && _t[next] <= x) {
+                    pos = next;
+                    x -= _t[next];
+                }
+            }
+            // guard against round-off pushing us past the last non-empty weight:
+            return (pos < _w.size()) ? pos : (_w.size() - 1);
+        }
+
+    protected:
+        //! Size the index for n weights, leaving _w untouched.
+        void resize_index(std::size_t n) {
+            _t.assign(n+1, T());
+            _mask = 1;
+            while((_mask << 1) <= n) {
+                _mask <<= 1;
+            }
+        }
+
+        std::vector<T> _w; //!< Weights.
+        std::vector<T> _t; //!< Tree; 1-indexed.
+        std::size_t _mask; //!< Highest power of two <= n.
+    };
+
+} // ealib
+
+#endif
@@ -0,0 +1,300 @@
+/* external_simulator.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_FITNESS_FUNCTIONS_EXTERNAL_SIMULATOR_H_
+#define _EA_FITNESS_FUNCTIONS_EXTERNAL_SIMULATOR_H_
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <ea/fitness_function.h>
+#include <ea/meta_data.h>
+#include <ea/batch_fitness.h>
+#include <ea/counter_rng.h>
+#include <ea/fitness_functions/farmed.h>
+
+namespace ealib {
+
+    LIBEA_MD_DECL(SIMULATOR_COMMAND, "ea.fitness_function.simulator.command", std::string);
+    LIBEA_MD_DECL(SIMULATOR_CONCURRENCY, "ea.fitness_function.simulator.concurrency", unsigned int);
+    LIBEA_MD_DECL(SIMULATOR_RETRIES, "ea.fitness_function.simulator.retries", unsigned int);
+
+    /*! Fitness function whose scores come from an external simulator.
+
+     SIMULATOR_CONCURRENCY copies (default: one per processor) of the shell
+     command SIMULATOR_COMMAND are started when the first genome is evaluated,
+     and are kept running.  Each is sent one genome per line on its standard
+     input, as a seed followed by the genome's sites,
+
+         2654435769 0 1 1 0 1 ...
+
+     and must reply with that genome's fitness on a line of its standard
+     output before it is sent the next.
+
+     Evaluation is asynchronous: all the genomes of a batch are handed out to
+     simulators as they become free, and the EA waits only on whichever reply
+     arrives next, so every simulator is kept busy while any genome remains.
+     Replies are stored by the genome's index in the batch, and each genome's
+     seed depends only on the batch's stamp (see ea/batch_fitness.h), so the
+     results, and thus the run, do not depend on the order in which simulators
+     finish.  The generational models that read fitness only after an offspring
+     is made, steady_state and death_birth_process, get this by wrapping their
+     selection strategies in selection::batch_evaluated.
+
+     A simulator that exits, or replies with something other than a number, is
+     restarted, and its genome is sent again, up to SIMULATOR_RETRIES times
+     (default 3) per genome.
+     */
+    template <typename T=boost::uint8_t>
+    struct external_simulator : fitness_function<unary_fitness<double>, constantS, stochasticS> {
+        typedef genome_batch<T, POPULATION_MAJOR> batch_type;
+
+        //! A running simulator.
+        struct simulator {
+            simulator() : fd(-1), pid(-1), row(-1) {
+            }
+
+            int fd; //!< Socket connected to the simulator's standard input and output.
+            pid_t pid; //!< Process id.
+            long row; //!< Row being evaluated, or -1 if idle.
+            std::string buffer; //!< Reply read so far.
+        };
+
+        //! Constructor.
+        external_simulator() : _seed(0) {
+        }
+
+        //! Copy constructor; copies share no simulators.
+        external_simulator(const external_simulator& that) : _seed(that._seed) {
+        }
+
+        //! Destructor; stops all simulators.
+        ~external_simulator() {
+            for(std::size_t i=0; i<_sims.size(); ++i) {
+                close(_sims[i].fd);
+            }
+            for(std::size_t i=0; i<_sims.size(); ++i) {
+                waitpid(_sims[i].pid, 0, 0);
+            }
+        }
+
+        //! Initialize this fitness function.
+        template <typename RNG, typename EA>
+        void initialize(RNG& rng, EA& ea) {
+            _seed = get<RNG_SEED>(ea, 0);
+            if(_seed == 0) {
+                _seed = rng.seed();
+            }
+        }
+
+        //! Evaluate a single individual, as a batch of one.
+        template <typename Individual, typename RNG, typename EA>
+        double operator()(Individual& ind, RNG& rng, EA& ea) {
+            const typename Individual::representation_type& repr=ind.repr();
+            batch_type b;
+            b.resize(1, repr.size());
+            b.set_genome(0, repr.begin(), repr.end());
+            b.stamp(ea.current_update(), detail::reserve_batch_indices(1, ea));
+            double f=0.0;
+            evaluate_batch(b, &f, ea);
+            return f;
+        }
+
+        //! Evaluate batch b on the simulators, setting f[i] to the fitness of its i'th genome.
+        template <typename EA>
+        void evaluate_batch(const batch_type& b, double* f, EA& ea) {
+            if(_sims.empty()) {
+                start(ea);
+            }
+            std::deque<std::size_t> queue;
+            for(std::size_t i=0; i<b.size(); ++i) {
+                queue.push_back(i);
+            }
+            std::vector<unsigned int> failures(b.size(), 0);
+            unsigned int retries=get<SIMULATOR_RETRIES>(ea, 3);
+            std::size_t done=0;
+
+            while(done < b.size()) {
+                // hand out genomes to idle simulators; a simulator that can't
+                // be sent to is restarted and sent to again (fail() gives up
+                // after the retry limit), so that every simulator is busy
+                // while there is work, and the poll below has something to
+                // wait for:
+                for(std::size_t s=0; s<_sims.size() && !queue.empty(); ++s) {
+                    while(_sims[s].row < 0 && !queue.empty()) {
+                        std::size_t i=queue.front();
+                        queue.pop_front();
+                        if(!send(_sims[s], b, i)) {
+                            fail(s, failures, retries, queue);
+                        }
+                    }
+                }
+
+                // wait for the next reply:
+                std::vector<pollfd> fds(_sims.size());
+                for(std::size_t s=0; s<_sims.size(); ++s) {
+                    fds[s].fd = (_sims[s].row < 0) ? -1 : _sims[s].fd;
+                    fds[s].events = POLLIN;
+                    fds[s].revents = 0;
+                }
+                if(poll(&fds[0], fds.size(), -1) < 0) {
+                    if(errno == EINTR) {
+                        continue;
+                    }
+                    farm::fail("poll failed");
+                }
+                for(std::size_t s=0; s<_sims.size(); ++s) {
+                    if(fds[s].revents == 0) {
+                        continue;
+                    }
+                    switch(receive(_sims[s], f)) {
+                        case 1: ++done; break;
+                        case -1: fail(s, failures, retries, queue); break;
+                        default: break;
+                    }
+                }
+            }
+        }
+
+    protected:
+        //! Start all simulators.
+        template <typename EA>
+        void start(EA& ea) {
+            long n=get<SIMULATOR_CONCURRENCY>(ea, 0);
+            if(n == 0) {
+                n = std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+            }
+            _command = get<SIMULATOR_COMMAND>(ea);
+            _sims.resize(n);
+            for(std::size_t s=0; s<_sims.size(); ++s) {
+                spawn(_sims[s]);
+            }
+        }
+
+        //! Start the simulator s.
+        void spawn(simulator& s) {
+            int sv[2];
+            if(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+                farm::fail("could not create simulator socket");
+            }
+            pid_t pid=fork();
+            if(pid == 0) {
+                close(sv[0]);
+                dup2(sv[1], STDIN_FILENO);
+                dup2(sv[1], STDOUT_FILENO);
+                close(sv[1]);
+                execl("/bin/sh", "sh", "-c", _command.c_str(), static_cast<char*>(0));
+                _exit(127);
+            } else if(pid < 0) {
+                farm::fail("could not fork simulator");
+            }
+            close(sv[1]);
+            // later simulators must not hold this one's socket open:
+            fcntl(sv[0], F_SETFD, FD_CLOEXEC);
+            s.fd = sv[0];
+            s.pid = pid;
+            s.row = -1;
+            s.buffer.clear();
+        }
+
+        //! Stop the simulator s.
+        void stop(simulator& s) {
+            if(s.fd >= 0) {
+                close(s.fd);
+                waitpid(s.pid, 0, 0);
+                s.fd = -1;
+            }
+        }
+
+        //! Send genome i of b to simulator s.
+        bool send(simulator& s, const batch_type& b, std::size_t i) {
+            counter_rng rng(_seed, static_cast<boost::uint32_t>(b.update()), static_cast<boost::uint32_t>(b.first() + i));
+            std::ostringstream line;
+            line << rng();
+            const T* g=b.vector(i);
+            for(std::size_t j=0; j<b.length(i); ++j) {
+                line << " " << static_cast<unsigned long>(g[j]);
+            }
+            line << "\n";
+            s.row = static_cast<long>(i);
+            std::string l=line.str();
+            return farm::write_all(s.fd, l.data(), l.size());
+        }
+
+        /*! Read what is available from simulator s; returns 1 if its reply is
+         complete (and stored in f), 0 if it is not, and -1 if the simulator failed.
+         */
+        int receive(simulator& s, double* f) {
+            char buf[256];
+            ssize_t r=recv(s.fd, buf, sizeof(buf), 0);
+            if(r < 0 && errno == EINTR) {
+                return 0;
+            } else if(r <= 0) {
+                return -1;
+            }
+            s.buffer.append(buf, r);
+            std::size_t nl=s.buffer.find('\n');
+            if(nl == std::string::npos) {
+                return 0;
+            }
+            std::string reply=s.buffer.substr(0, nl);
+            char* end=0;
+            double x=std::strtod(reply.c_str(), &end);
+            if(end == reply.c_str() || nl+1 != s.buffer.size()) {
+                return -1;
+            }
+            f[s.row] = x;
+            s.row = -1;
+            s.buffer.clear();
+            return 1;
+        }
+
+        //! Restart failed simulator s, and requeue its genome.
+        void fail(std::size_t s, std::vector<unsigned int>& failures, unsigned int retries, std::deque<std::size_t>& queue) {
+            std::size_t i=static_cast<std::size_t>(_sims[s].row);
+            if(++failures[i] > retries) {
+                throw std::runtime_error("external simulator failed repeatedly on the same genome: " + _command);
+            }
+            queue.push_front(i);
+            kill(_sims[s].pid, SIGKILL);
+            stop(_sims[s]);
+            spawn(_sims[s]);
+        }
+
+        boost::uint64_t _seed; //!< Seed of all genome streams.
+        std::string _command; //!< Simulator command.
+        std::vector<simulator> _sims; //!< Running simulators.
+    };
+
+} // ealib
+
+#endif
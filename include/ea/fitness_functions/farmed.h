@@ -0,0 +1,582 @@
+/* farmed.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_FITNESS_FUNCTIONS_FARMED_H_
+#define _EA_FITNESS_FUNCTIONS_FARMED_H_
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/lexical_cast.hpp>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <ea/meta_data.h>
+#include <ea/batch_fitness.h>
+#include <ea/fitness_functions/racing.h>
+
+namespace ealib {
+
+    LIBEA_MD_DECL(FARM_WORKERS, "ea.fitness_function.farm.workers", unsigned int);
+    LIBEA_MD_DECL(FARM_ADDRESS, "ea.fitness_function.farm.address", std::string);
+    LIBEA_MD_DECL(FARM_CHUNK_SIZE, "ea.fitness_function.farm.chunk_size", unsigned int);
+    LIBEA_MD_DECL(FARM_PIPELINE_DEPTH, "ea.fitness_function.farm.pipeline_depth", unsigned int);
+
+    /* Wire protocol and socket plumbing of the evaluation farm.
+
+     A request is a request_header, the length of each of its genomes (as
+     uint32), and its genome_batch matrix, in the batch's own layout and site
+     type.  A reply is a reply_header and one double per genome.  Both ends run
+     on the same architecture, so nothing is byte-swapped.
+
+     The meta-data that the master changes as it runs travels with each
+     request (the racing threshold), and the racing statistics of each chunk
+     travel back with its reply, so that evaluating a chunk on a worker is
+     the same as evaluating it locally.
+     */
+    namespace farm {
+
+        const boost::uint32_t REQUEST_MAGIC=0x52464145; // "EAFR"
+        const boost::uint32_t REPLY_MAGIC=0x50464145; // "EAFP"
+
+        struct request_header {
+            boost::uint32_t magic;
+            boost::uint32_t chunk; //!< Chunk id, echoed in the reply.
+            boost::uint32_t rows; //!< Number of genomes.
+            boost::uint32_t length; //!< Sites per genome, including padding.
+            boost::uint64_t update; //!< Batch stamp.
+            boost::uint64_t first; //!< Batch stamp.
+            double threshold; //!< The master's RACING_THRESHOLD.
+        };
+
+        struct reply_header {
+            boost::uint32_t magic;
+            boost::uint32_t chunk;
+            boost::uint32_t rows;
+            boost::uint32_t reserved;
+            racing_stats racing; //!< Racing statistics of the chunk.
+        };
+
+        //! Returns the difference a-b of two sets of racing statistics.
+        inline racing_stats operator-(const racing_stats& a, const racing_stats& b) {
+            racing_stats d;
+            d.races = a.races - b.races;
+            d.aborted = a.aborted - b.aborted;
+            d.extended = a.extended - b.extended;
+            d.trials = a.trials - b.trials;
+            return d;
+        }
+
+        //! Adds the racing statistics d to s.
+        inline void add_racing_stats(racing_stats& s, const racing_stats& d) {
+            s.races += d.races;
+            s.aborted += d.aborted;
+            s.extended += d.extended;
+            s.trials += d.trials;
+        }
+
+        //! Write all n bytes of p to fd; returns false on error or if the peer is gone.
+        inline bool write_all(int fd, const void* p, std::size_t n) {
+            const char* c=static_cast<const char*>(p);
+            while(n > 0) {
+                ssize_t w=send(fd, c, n, MSG_NOSIGNAL);
+                if(w < 0 && errno == EINTR) {
+                    continue;
+                } else if(w <= 0) {
+                    return false;
+                }
+                c += w;
+                n -= w;
+            }
+            return true;
+        }
+
+        //! Read exactly n bytes from fd into p; returns false on error or end of file.
+        inline bool read_all(int fd, void* p, std::size_t n) {
+            char* c=static_cast<char*>(p);
+            while(n > 0) {
+                ssize_t r=recv(fd, c, n, 0);
+                if(r < 0 && errno == EINTR) {
+                    continue;
+                } else if(r <= 0) {
+                    return false;
+                }
+                c += r;
+                n -= r;
+            }
+            return true;
+        }
+
+        inline void fail(const std::string& what) {
+            throw std::runtime_error("evaluation farm: " + what + ": " + std::strerror(errno));
+        }
+
+        /*! Returns a socket listening on address, which is either "unix:<path>"
+         or "tcp:<port>" (on all interfaces).
+         */
+        inline int listen_on(const std::string& address) {
+            int fd=-1;
+            if(address.compare(0, 5, "unix:") == 0) {
+                std::string path=address.substr(5);
+                sockaddr_un sa;
+                std::memset(&sa, 0, sizeof(sa));
+                sa.sun_family = AF_UNIX;
+                std::strncpy(sa.sun_path, path.c_str(), sizeof(sa.sun_path)-1);
+                unlink(path.c_str());
+                if((fd=socket(AF_UNIX, SOCK_STREAM, 0)) < 0
+                   || bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) < 0) {
+                    fail("could not bind " + address);
+                }
+            } else if(address.compare(0, 4, "tcp:") == 0) {
+                sockaddr_in sa;
+                std::memset(&sa, 0, sizeof(sa));
+                sa.sin_family = AF_INET;
+                sa.sin_addr.s_addr = htonl(INADDR_ANY);
+                sa.sin_port = htons(static_cast<boost::uint16_t>(std::atoi(address.c_str()+4)));
+                int one=1;
+                if((fd=socket(AF_INET, SOCK_STREAM, 0)) < 0
+                   || setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0
+                   || bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) < 0) {
+                    fail("could not bind " + address);
+                }
+            } else {
+                throw std::runtime_error("evaluation farm: bad address " + address);
+            }
+            if(listen(fd, 64) < 0) {
+                fail("could not listen on " + address);
+            }
+            return fd;
+        }
+
+        /*! Returns a socket connected to address, which is either "unix:<path>"
+         or "tcp:<host>:<port>".
+         */
+        inline int connect_to(const std::string& address) {
+            int fd=-1;
+            if(address.compare(0, 5, "unix:") == 0) {
+                sockaddr_un sa;
+                std::memset(&sa, 0, sizeof(sa));
+                sa.sun_family = AF_UNIX;
+                std::strncpy(sa.sun_path, address.c_str()+5, sizeof(sa.sun_path)-1);
+                if((fd=socket(AF_UNIX, SOCK_STREAM, 0)) < 0
+                   || connect(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) < 0) {
+                    fail("could not connect to " + address);
+                }
+            } else if(address.compare(0, 4, "tcp:") == 0) {
+                std::size_t colon=address.rfind(':');
+                std::string host=address.substr(4, colon-4), port=address.substr(colon+1);
+                addrinfo hints, *ai=0;
+                std::memset(&hints, 0, sizeof(hints));
+                hints.ai_family = AF_INET;
+                hints.ai_socktype = SOCK_STREAM;
+                if(getaddrinfo(host.c_str(), port.c_str(), &hints, &ai) != 0) {
+                    throw std::runtime_error("evaluation farm: could not resolve " + address);
+                }
+                int one=1;
+                if((fd=socket(AF_INET, SOCK_STREAM, 0)) < 0
+                   || connect(fd, ai->ai_addr, ai->ai_addrlen) < 0) {
+                    freeaddrinfo(ai);
+                    fail("could not connect to " + address);
+                }
+                freeaddrinfo(ai);
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            } else {
+                throw std::runtime_error("evaluation farm: bad address " + address);
+            }
+            return fd;
+        }
+
+        //! Send genomes [a,b) of b as request chunk c on fd, with racing threshold t.
+        template <typename Batch>
+        bool send_chunk(int fd, const Batch& batch, std::size_t a, std::size_t b, std::size_t c, double t) {
+            Batch sub;
+            sub.resize(b-a, batch.length());
+            std::vector<boost::uint32_t> lengths(b-a);
+            for(std::size_t i=a; i<b; ++i) {
+                lengths[i-a] = static_cast<boost::uint32_t>(batch.length(i));
+                for(std::size_t j=0; j<batch.length(i); ++j) {
+                    sub(i-a, j) = batch(i, j);
+                }
+            }
+            request_header h;
+            h.magic = REQUEST_MAGIC;
+            h.chunk = static_cast<boost::uint32_t>(c);
+            h.rows = static_cast<boost::uint32_t>(b-a);
+            h.length = static_cast<boost::uint32_t>(batch.length());
+            h.update = batch.update();
+            h.first = batch.first() + a;
+            h.threshold = t;
+            return write_all(fd, &h, sizeof(h))
+            && write_all(fd, &lengths[0], lengths.size() * sizeof(boost::uint32_t))
+            && write_all(fd, sub.data(), sub.size() * sub.length() * sizeof(typename Batch::value_type));
+        }
+
+        /*! Serve evaluation requests arriving on fd with fitness function ff,
+         until the connection is closed.
+         */
+        template <typename FitnessFunction, typename EA>
+        void serve(int fd, FitnessFunction& ff, EA& ea) {
+            typedef typename FitnessFunction::batch_type batch_type;
+            request_header h;
+            std::vector<boost::uint32_t> lengths;
+            std::vector<double> f;
+            while(read_all(fd, &h, sizeof(h)) && (h.magic == REQUEST_MAGIC) && (h.rows > 0)) {
+                batch_type b;
+                b.resize(h.rows, h.length);
+                lengths.resize(h.rows);
+                if(!read_all(fd, &lengths[0], h.rows * sizeof(boost::uint32_t))
+                   || !read_all(fd, b.data(), b.size() * b.length() * sizeof(typename batch_type::value_type))) {
+                    break;
+                }
+                for(std::size_t i=0; i<h.rows; ++i) {
+                    b.set_length(i, lengths[i]);
+                }
+                b.stamp(static_cast<unsigned long>(h.update), static_cast<std::size_t>(h.first));
+                put<RACING_THRESHOLD>(h.threshold, ea);
+
+                f.resize(h.rows);
+                racing_stats before=global_racing_stats();
+                ff.evaluate_batch(b, &f[0], ea);
+
+                reply_header r;
+                r.magic = REPLY_MAGIC;
+                r.chunk = h.chunk;
+                r.rows = h.rows;
+                r.reserved = 0;
+                r.racing = global_racing_stats() - before;
+                if(!write_all(fd, &r, sizeof(r)) || !write_all(fd, &f[0], f.size() * sizeof(double))) {
+                    break;
+                }
+            }
+            close(fd);
+        }
+
+        /*! Connect to the farm at address and serve its requests until it shuts
+         down.  This is how a worker on another host joins a farm: any process
+         that can construct and configure the same EA calls, e.g.,
+         farm::worker("tcp:master:7000", ea.fitness_function(), ea).
+         */
+        template <typename FitnessFunction, typename EA>
+        void worker(const std::string& address, FitnessFunction& ff, EA& ea) {
+            serve(connect_to(address), ff, ea);
+        }
+
+    } // farm
+
+
+    /*! Farms the batch evaluations of a fitness function out to worker
+     processes over sockets.
+
+     The first batch starts FARM_WORKERS local workers (forks of this process,
+     which thus share its configuration), listening at FARM_ADDRESS: either
+     "unix:<path>" (the default, unix:ealib_farm_<pid>) or "tcp:<port>", to
+     which remote workers may also connect at any time (see farm::worker).
+
+     Each batch is split into chunks of FARM_CHUNK_SIZE genomes (default 16).
+     Every worker is kept up to FARM_PIPELINE_DEPTH chunks ahead (default 2),
+     so that it never waits on the master, and is sent its next chunk as soon
+     as it replies, so faster workers take more of the batch.  If a worker dies,
+     its outstanding chunks are sent to the others; if none are left, the rest
+     of the batch is evaluated locally.  Results are placed by chunk, and
+     batches are stamped (see ea/batch_fitness.h), so the outcome does not
+     depend on which worker evaluated what.
+
+     Workers are forked when the first batch is evaluated, and so see the EA's
+     meta-data as of that moment, except for the racing threshold, which is
+     sent with every chunk; racing statistics are sent back, and counted in
+     this process.  A local worker that does not connect within a few seconds
+     is killed, and the farm carries on without it.  With no workers, batches
+     are evaluated in this process, as if the fitness function were not
+     farmed.
+     */
+    template <typename FitnessFunction>
+    struct farmed : FitnessFunction {
+        typedef typename FitnessFunction::batch_type batch_type;
+
+        //! A connection to a worker.
+        struct worker_connection {
+            worker_connection(int f) : fd(f) {
+            }
+
+            int fd;
+            std::deque<std::size_t> inflight; //!< Chunks sent and not yet answered, in order.
+        };
+
+        //! Constructor.
+        farmed() : _listen(-1), _started(false) {
+        }
+
+        //! Copy constructor; copies share no workers.
+        farmed(const farmed& that) : FitnessFunction(that), _listen(-1), _started(false) {
+        }
+
+        //! Destructor; shuts down all workers.
+        ~farmed() {
+            shutdown();
+        }
+
+        //! Evaluate batch b, setting f[i] to the fitness of its i'th genome.
+        template <typename EA>
+        void evaluate_batch(const batch_type& b, double* f, EA& ea) {
+            if(!_started) {
+                start(ea);
+            }
+            accept_pending();
+            if(_workers.empty()) {
+                FitnessFunction::evaluate_batch(b, f, ea);
+                return;
+            }
+
+            std::size_t cs=std::max(1u, get<FARM_CHUNK_SIZE>(ea, 16));
+            std::size_t depth=std::max(1u, get<FARM_PIPELINE_DEPTH>(ea, 2));
+            std::size_t nchunks=(b.size() + cs - 1) / cs;
+            double threshold=get<RACING_THRESHOLD>(ea, 0.0);
+            std::deque<std::size_t> queue;
+            for(std::size_t c=0; c<nchunks; ++c) {
+                queue.push_back(c);
+            }
+
+            std::size_t done=0;
+            while(done < nchunks) {
+                // keep every worker's pipeline full:
+                for(std::size_t w=0; w<_workers.size(); ) {
+                    worker_connection& k=_workers[w];
+                    bool ok=true;
+                    while(ok && !queue.empty() && k.inflight.size() < depth) {
+                        std::size_t c=queue.front();
+                        if((ok=farm::send_chunk(k.fd, b, c*cs, std::min(b.size(), (c+1)*cs), c, threshold))) {
+                            queue.pop_front();
+                            k.inflight.push_back(c);
+                        }
+                    }
+                    if(ok) {
+                        ++w;
+                    } else {
+                        lose(w, queue);
+                    }
+                }
+
+                if(_workers.empty()) {
+                    // no one left; finish the batch here:
+                    for( ; !queue.empty(); queue.pop_front(), ++done) {
+                        evaluate_locally(b, queue.front(), cs, f, ea);
+                    }
+                    break;
+                }
+
+                // wait for replies:
+                std::vector<pollfd> fds(_workers.size());
+                for(std::size_t w=0; w<_workers.size(); ++w) {
+                    fds[w].fd = _workers[w].fd;
+                    fds[w].events = POLLIN;
+                    fds[w].revents = 0;
+                }
+                if(poll(&fds[0], fds.size(), -1) < 0) {
+                    if(errno == EINTR) {
+                        continue;
+                    }
+                    farm::fail("poll failed");
+                }
+                for(std::size_t w=fds.size(); w-- > 0; ) {
+                    if(fds[w].revents == 0) {
+                        continue;
+                    }
+                    if(receive(_workers[w], b, cs, f)) {
+                        ++done;
+                    } else {
+                        lose(w, queue);
+                    }
+                }
+            }
+        }
+
+    protected:
+        //! Listen for workers, and fork the local ones.
+        template <typename EA>
+        void start(EA& ea) {
+            _started = true;
+            unsigned int n=get<FARM_WORKERS>(ea, 0);
+            if(n == 0) {
+                return;
+            }
+            _address = get<FARM_ADDRESS>(ea, "unix:ealib_farm_" + boost::lexical_cast<std::string>(getpid()));
+            _listen = farm::listen_on(_address);
+            std::string local=_address;
+            if(local.compare(0, 4, "tcp:") == 0) {
+                local = "tcp:127.0.0.1:" + local.substr(4);
+            }
+
+            for(unsigned int i=0; i<n; ++i) {
+                pid_t pid=fork();
+                if(pid == 0) {
+                    close(_listen);
+                    for(std::size_t w=0; w<_workers.size(); ++w) {
+                        close(_workers[w].fd);
+                    }
+                    try {
+                        farm::worker(local, static_cast<FitnessFunction&>(*this), ea);
+                    } catch(...) {
+                        _exit(1);
+                    }
+                    _exit(0);
+                } else if(pid < 0) {
+                    farm::fail("could not fork worker");
+                }
+                _children.push_back(pid);
+                int fd=accept_worker(pid);
+                if(fd >= 0) {
+                    _workers.push_back(worker_connection(fd));
+                }
+            }
+            fcntl(_listen, F_SETFL, fcntl(_listen, F_GETFL) | O_NONBLOCK);
+        }
+
+        /*! Returns a connection from the local worker pid, or -1 if it exits
+         or does not connect within the time limit, in which case it is reaped.
+         */
+        int accept_worker(pid_t pid) {
+            pollfd p;
+            p.fd = _listen;
+            p.events = POLLIN;
+            for(int waited=0; waited<10000; waited+=100) {
+                p.revents = 0;
+                int n=poll(&p, 1, 100);
+                if(n < 0 && errno != EINTR) {
+                    farm::fail("poll failed");
+                } else if(n > 0) {
+                    int fd=accept(_listen, 0, 0);
+                    if(fd >= 0) {
+                        return fd;
+                    } else if(errno != EINTR && errno != EAGAIN && errno != ECONNABORTED) {
+                        farm::fail("could not accept worker");
+                    }
+                }
+                if(waitpid(pid, 0, WNOHANG) == pid) {
+                    _children.erase(std::find(_children.begin(), _children.end(), pid));
+                    return -1;
+                }
+            }
+            kill(pid, SIGKILL);
+            waitpid(pid, 0, 0);
+            _children.erase(std::find(_children.begin(), _children.end(), pid));
+            return -1;
+        }
+
+        //! Add any workers that have connected since the last batch.
+        void accept_pending() {
+            if(_listen < 0) {
+                return;
+            }
+            int fd;
+            while((fd=accept(_listen, 0, 0)) >= 0) {
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+                _workers.push_back(worker_connection(fd));
+            }
+        }
+
+        //! Read one reply from k into f; returns false if the worker is gone.
+        bool receive(worker_connection& k, const batch_type& b, std::size_t cs, double* f) {
+            farm::reply_header r;
+            if(k.inflight.empty()
+               || !farm::read_all(k.fd, &r, sizeof(r))
+               || r.magic != farm::REPLY_MAGIC
+               || r.chunk != k.inflight.front()) {
+                return false;
+            }
+            std::size_t a=r.chunk * cs, n=std::min(b.size(), a+cs) - a;
+            if(r.rows != n || !farm::read_all(k.fd, f+a, n * sizeof(double))) {
+                return false;
+            }
+            farm::add_racing_stats(global_racing_stats(), r.racing);
+            k.inflight.pop_front();
+            return true;
+        }
+
+        //! Drop worker w, returning its outstanding chunks to the front of queue.
+        void lose(std::size_t w, std::deque<std::size_t>& queue) {
+            worker_connection& k=_workers[w];
+            queue.insert(queue.begin(), k.inflight.begin(), k.inflight.end());
+            close(k.fd);
+            _workers.erase(_workers.begin()+w);
+        }
+
+        //! Evaluate chunk c of b in this process.
+        template <typename EA>
+        void evaluate_locally(const batch_type& b, std::size_t c, std::size_t cs, double* f, EA& ea) {
+            std::size_t a=c*cs, e=std::min(b.size(), a+cs);
+            batch_type sub;
+            sub.resize(e-a, b.length());
+            for(std::size_t i=a; i<e; ++i) {
+                for(std::size_t j=0; j<b.length(i); ++j) {
+                    sub(i-a, j) = b(i, j);
+                }
+                sub.set_length(i-a, b.length(i));
+            }
+            sub.stamp(b.update(), b.first() + a);
+            FitnessFunction::evaluate_batch(sub, f+a, ea);
+        }
+
+        //! Close all connections, and reap the local workers.
+        void shutdown() {
+            for(std::size_t w=0; w<_workers.size(); ++w) {
+                close(_workers[w].fd);
+            }
+            _workers.clear();
+            for(std::size_t i=0; i<_children.size(); ++i) {
+                waitpid(_children[i], 0, 0);
+            }
+            _children.clear();
+            if(_listen >= 0) {
+                close(_listen);
+                if(_address.compare(0, 5, "unix:") == 0) {
+                    unlink(_address.c_str()+5);
+                }
+                _listen = -1;
+            }
+        }
+
+        int _listen; //!< Listening socket.
+        bool _started; //!< Whether the farm has been started.
+        std::string _address; //!< Address of the listening socket.
+        std::vector<worker_connection> _workers; //!< Live workers.
+        std::vector<pid_t> _children; //!< Local worker processes.
+    };
+
+    //! A farmed fitness function has a batch interface only if the one it wraps does.
+    template <typename FitnessFunction>
+    struct has_batch_evaluation<farmed<FitnessFunction> > : has_batch_evaluation<FitnessFunction> {
+    };
+
+} // ealib
+
+#endif
@@ -0,0 +1,193 @@
+/* memoized.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_FITNESS_FUNCTIONS_MEMOIZED_H_
+#define _EA_FITNESS_FUNCTIONS_MEMOIZED_H_
+
+#include <boost/cstdint.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/unordered_map.hpp>
+#include <ea/fitness_function.h>
+#include <ea/meta_data.h>
+#include <ea/batch_fitness.h>
+
+namespace ealib {
+
+    LIBEA_MD_DECL(FITNESS_CACHE_CAPACITY, "ea.fitness_function.cache.capacity", std::size_t);
+
+    //! 128-bit hash of a genome.
+    struct genome_hash {
+        bool operator==(const genome_hash& that) const {
+            return (h1 == that.h1) && (h2 == that.h2);
+        }
+
+        boost::uint64_t h1;
+        boost::uint64_t h2;
+    };
+
+    //! Hash functor for genome_hash keys (which are already well-mixed).
+    struct genome_hash_hasher {
+        std::size_t operator()(const genome_hash& h) const {
+            return static_cast<std::size_t>(h.h1 ^ h.h2);
+        }
+    };
+
+    namespace detail {
+
+        inline boost::uint64_t rotl64(boost::uint64_t x, int r) {
+            return (x << r) | (x >> (64 - r));
+        }
+
+        //! Final avalanche of a 64-bit value (from MurmurHash3).
+        inline boost::uint64_t fmix64(boost::uint64_t k) {
+            k ^= k >> 33;
+            k *= 0xff51afd7ed558ccdULL;
+            k ^= k >> 33;
+            k *= 0xc4ceb9fe1a85ec53ULL;
+            k ^= k >> 33;
+            return k;
+        }
+
+    } // detail
+
+    /*! Returns a 128-bit hash of the sites in [f,l).  Each site is mixed into
+     two independent 64-bit lanes, so the chance that two different genomes
+     collide is negligible for any population we are likely to evaluate.
+     */
+    template <typename ForwardIterator>
+    genome_hash hash_genome(ForwardIterator f, ForwardIterator l) {
+        using namespace detail;
+        const boost::uint64_t c1=0x87c37b91114253d5ULL, c2=0x4cf5ad432745937fULL;
+        boost::uint64_t h1=0x9e3779b97f4a7c15ULL, h2=0x6a09e667f3bcc909ULL, n=0;
+        for( ; f!=l; ++f, ++n) {
+            boost::uint64_t k=static_cast<boost::uint64_t>(*f);
+            h1 = rotl64(h1 ^ (k * c1), 27) * 5 + 0x52dce729;
+            h2 = rotl64(h2 ^ (rotl64(k, 33) * c2), 31) * 5 + 0x38495ab5;
+        }
+        h1 ^= n;
+        h2 ^= n;
+        h1 += h2;
+        h2 += h1;
+        genome_hash h;
+        h.h1 = fmix64(h1) + fmix64(h2);
+        h.h2 = fmix64(h2) + h.h1;
+        return h;
+    }
+
+    //! Hit and miss counts of all fitness caches.
+    struct fitness_cache_stats {
+        fitness_cache_stats() : hits(0), misses(0), entries(0) {
+        }
+
+        boost::uint64_t hits;
+        boost::uint64_t misses;
+        std::size_t entries;
+    };
+
+    //! Returns the process-wide fitness cache statistics.
+    inline fitness_cache_stats& global_cache_stats() {
+        static fitness_cache_stats s;
+        return s;
+    }
+
+    /*! Caches the fitness of each distinct genome evaluated by a deterministic,
+     constant fitness function.
+
+     Offspring that are unmutated clones, or that are recreated by crossover or
+     migration, are then not evaluated again.  The cache is keyed on a 128-bit
+     hash of the genome, and is shared by every instance of memoized<FitnessFunction>
+     in the process: across islands of a meta-population, and across epochs.
+     When it grows beyond FITNESS_CACHE_CAPACITY entries (default 2^20), it is
+     cleared; a capacity of 0 turns memoization off, and genomes are then not
+     even hashed.  The cache is guarded by a mutex, which is not held while the
+     wrapped fitness function runs, so islands evaluated on different threads
+     may share it.
+
+     Only fitness functions tagged constantS and deterministic (i.e., not
+     stochasticS) may be memoized; this is checked at compile time.  Hit rates
+     are written by datafiles::fitness_cache.  A memoized fitness function
+     does not offer the batch interface of the one it wraps, as batches would
+     bypass the cache.
+     */
+    template <typename FitnessFunction>
+    struct memoized : FitnessFunction {
+        typedef typename FitnessFunction::fitness_type fitness_type;
+        typedef boost::unordered_map<genome_hash, fitness_type, genome_hash_hasher> cache_type;
+
+        BOOST_STATIC_ASSERT((boost::is_same<typename FitnessFunction::constant_tag, constantS>::value));
+        BOOST_STATIC_ASSERT((!boost::is_same<typename FitnessFunction::stochastic_tag, stochasticS>::value));
+
+        //! Returns the cache shared by all memoized<FitnessFunction>.
+        static cache_type& cache() {
+            static cache_type c;
+            return c;
+        }
+
+        //! Returns the mutex that guards cache() and global_cache_stats().
+        static boost::mutex& cache_mutex() {
+            static boost::mutex m;
+            return m;
+        }
+
+        template <typename Individual, typename EA>
+        fitness_type operator()(Individual& ind, EA& ea) {
+            std::size_t capacity=get<FITNESS_CACHE_CAPACITY>(ea, 1u << 20);
+            if(capacity == 0) {
+                return FitnessFunction::operator()(ind, ea);
+            }
+
+            const typename Individual::representation_type& repr=ind.repr();
+            genome_hash h=hash_genome(repr.begin(), repr.end());
+            fitness_cache_stats& s=global_cache_stats();
+            cache_type& c=cache();
+            {
+                boost::lock_guard<boost::mutex> lock(cache_mutex());
+                typename cache_type::iterator i=c.find(h);
+                if(i != c.end()) {
+                    ++s.hits;
+                    return i->second;
+                }
+                ++s.misses;
+            }
+
+            fitness_type f=FitnessFunction::operator()(ind, ea);
+
+            boost::lock_guard<boost::mutex> lock(cache_mutex());
+            if(c.size() >= capacity) {
+                s.entries -= c.size();
+                c.clear();
+            }
+            if(c.insert(std::make_pair(h, f)).second) {
+                ++s.entries;
+            }
+            return f;
+        }
+    };
+
+    template <typename FitnessFunction>
+    struct has_batch_evaluation<memoized<FitnessFunction> > {
+        enum { value = 0 };
+    };
+
+} // ealib
+
+#endif
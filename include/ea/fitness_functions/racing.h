@@ -0,0 +1,192 @@
+/* racing.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_FITNESS_FUNCTIONS_RACING_H_
+#define _EA_FITNESS_FUNCTIONS_RACING_H_
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <ea/events.h>
+#include <ea/meta_data.h>
+
+namespace ealib {
+
+    LIBEA_MD_DECL(RACING_THRESHOLD, "ea.fitness_function.racing.threshold", double);
+    LIBEA_MD_DECL(RACING_QUANTILE, "ea.fitness_function.racing.quantile", double);
+    LIBEA_MD_DECL(RACING_DELTA, "ea.fitness_function.racing.delta", double);
+    LIBEA_MD_DECL(RACING_EXTRA_TRIALS, "ea.fitness_function.racing.extra_trials", unsigned int);
+
+    //! Counts of races run by all fitness functions in the process.
+    struct racing_stats {
+        racing_stats() : races(0), aborted(0), extended(0), trials(0) {
+        }
+
+        boost::uint64_t races; //!< Evaluations that used a race.
+        boost::uint64_t aborted; //!< Races stopped early because they could not reach the threshold.
+        boost::uint64_t extended; //!< Races given extra trials because they were too close to call.
+        boost::uint64_t trials; //!< Trials run.
+    };
+
+    //! Returns the process-wide racing statistics.
+    inline racing_stats& global_racing_stats() {
+        static racing_stats s;
+        return s;
+    }
+
+    /*! Early termination of a fitness evaluation that is the mean of a series of
+     independent trials, each scoring in [0,1].
+
+     After t trials with mean m, the Hoeffding bound says that, with
+     probability at least 1-d, the true mean is below m + sqrt(ln(1/d)/2t).
+     The bound is tested after every trial, up to n+extra times, so each test
+     uses d = delta/(n+extra); by the union bound, the chance that any of them
+     wrongly stops a race is then at most delta.
+     Once that bound falls below the threshold, the individual has lost: more
+     trials will not change the fact that its fitness is too low to matter, and
+     the race stops.  Conversely, an individual whose mean after the usual n
+     trials is within the bound of the threshold is too close to call, and may
+     be given up to extra more trials.  A threshold of 0 (no threshold) turns
+     racing off: the race simply runs n trials.
+
+     A fitness function uses a race like so:
+
+         race r(threshold, n, ea);
+         while(r.running()) {
+             r(one_trial());
+         }
+         return n * r.mean();
+
+     so that fitness stays on the same scale however many trials were run.
+     */
+    class race {
+    public:
+        /*! Constructor; threshold is in units of the per-trial mean, and n is the
+         usual number of trials.
+         */
+        race(double threshold, std::size_t n, double delta, std::size_t extra)
+        : _threshold(threshold), _n(n), _extra(extra), _t(0), _sum(0.0), _extended(false) {
+            _c = std::log((_n + _extra) / delta) / 2.0;
+            ++global_racing_stats().races;
+        }
+
+        /*! Constructor that reads the threshold (in units of fitness, i.e., n
+         times the per-trial mean), delta, and extra trials from ea.  Without a
+         threshold, the race simply runs n trials.
+         */
+        template <typename EA>
+        race(std::size_t n, EA& ea)
+        : _threshold(get<RACING_THRESHOLD>(ea, 0.0) / n), _n(n), _extra(get<RACING_EXTRA_TRIALS>(ea, 0))
+        , _t(0), _sum(0.0), _extended(false) {
+            _c = std::log((_n + _extra) / get<RACING_DELTA>(ea, 0.05)) / 2.0;
+            ++global_racing_stats().races;
+        }
+
+        //! Record the score x (in [0,1]) of one trial.
+        void operator()(double x) {
+            _sum += x;
+            ++_t;
+            ++global_racing_stats().trials;
+        }
+
+        //! Returns the half-width of the confidence interval after the trials so far.
+        double epsilon() const {
+            return std::sqrt(_c / _t);
+        }
+
+        //! Returns true if more trials should be run.
+        bool running() {
+            if(_t == 0) {
+                return true;
+            }
+            if(_threshold <= 0.0) {
+                return _t < _n;
+            }
+            if(mean() + epsilon() < _threshold) {
+                ++global_racing_stats().aborted;
+                return false;
+            }
+            if(_t < _n) {
+                return true;
+            }
+            if(_t < (_n + _extra) && std::fabs(mean() - _threshold) < epsilon()) {
+                if(!_extended) {
+                    _extended = true;
+                    ++global_racing_stats().extended;
+                }
+                return true;
+            }
+            return false;
+        }
+
+        //! Returns the mean score of the trials so far.
+        double mean() const {
+            return (_t > 0) ? (_sum / _t) : 0.0;
+        }
+
+        //! Returns the number of trials run.
+        std::size_t trials() const {
+            return _t;
+        }
+
+    protected:
+        double _threshold; //!< Threshold, per trial.
+        std::size_t _n; //!< Usual number of trials.
+        std::size_t _extra; //!< Maximum extra trials for borderline individuals.
+        std::size_t _t; //!< Trials run so far.
+        double _sum; //!< Sum of trial scores.
+        double _c; //!< ln((n+extra)/delta)/2.
+        bool _extended; //!< Whether extra trials have been run.
+    };
+
+    /*! Sets RACING_THRESHOLD at the end of each update to the RACING_QUANTILE
+     quantile of fitness in the population, so that offspring that are all but
+     certain to fall below that fraction of the population stop being evaluated
+     early.  A quantile of 0 (the default) leaves racing off.
+     */
+    template <typename EA>
+    struct racing_threshold : end_of_update_event<EA> {
+        racing_threshold(EA& ea) : end_of_update_event<EA>(ea) {
+        }
+
+        virtual ~racing_threshold() {
+        }
+
+        virtual void operator()(EA& ea) {
+            double quantile=get<RACING_QUANTILE>(ea, 0.0);
+            if(quantile <= 0.0 || ea.population().empty()) {
+                put<RACING_THRESHOLD>(0.0, ea);
+                return;
+            }
+            _f.clear();
+            for(typename EA::population_type::iterator i=ea.population().begin(); i!=ea.population().end(); ++i) {
+                _f.push_back(static_cast<double>(ealib::fitness(**i, ea)));
+            }
+            std::size_t q=static_cast<std::size_t>(std::min(quantile, 1.0) * (_f.size() - 1));
+            std::nth_element(_f.begin(), _f.begin()+q, _f.end());
+            put<RACING_THRESHOLD>(_f[q], ea);
+        }
+
+        std::vector<double> _f; //!< Population fitnesses.
+    };
+
+} // ealib
+
+#endif
@@ -0,0 +1,220 @@
+/* live_metrics_ring.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_LIVE_METRICS_RING_H_
+#define _EA_LIVE_METRICS_RING_H_
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <boost/cstdint.hpp>
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+/* Shared-memory layout used to publish per-update statistics from a running EA
+ to local monitoring processes.  This header deliberately does not depend on the
+ rest of ealib, so that small reader programs can include it on its own.
+
+ The segment holds a header followed by a fixed number of slots.  The writer
+ never blocks and never waits for readers: each slot is protected by a sequence
+ counter (a seqlock), which is odd while the slot is being written.  A reader
+ copies a slot and re-reads its counter; if the counter changed or is odd, the
+ copy is discarded.
+ */
+
+namespace ealib {
+
+    /*! Statistics published for a single update.
+     */
+    struct metrics_record {
+        boost::int64_t update;
+        boost::int64_t population_size;
+        double mean_fitness;
+        double min_fitness;
+        double max_fitness;
+    };
+
+    //! Header at the start of the shared-memory segment.
+    struct metrics_ring_header {
+        char magic[8];
+        boost::uint32_t version;
+        boost::uint32_t capacity;
+        boost::atomic<boost::uint64_t> count; //!< Total number of records ever written.
+    };
+
+    //! A single slot in the ring.
+    struct metrics_ring_slot {
+        boost::atomic<boost::uint64_t> seq;
+        metrics_record rec;
+    };
+
+    namespace detail {
+        inline const char* metrics_magic() {
+            return "EAMETRC";
+        }
+
+        inline std::size_t metrics_segment_size(std::size_t capacity) {
+            return sizeof(metrics_ring_header) + capacity * sizeof(metrics_ring_slot);
+        }
+    }
+
+    /*! Creates a shared-memory metrics ring and writes records into it.
+
+     The segment is removed when the writer is destroyed.
+     */
+    class metrics_ring_writer : boost::noncopyable {
+    public:
+        /*! Constructor; creates (or replaces) the segment called name, with room
+         for capacity records.  Throws if capacity is zero.
+         */
+        metrics_ring_writer(const std::string& name, std::size_t capacity) : _name(name) {
+            using namespace boost::interprocess;
+            if((capacity == 0) || (capacity > 0xffffffffu)) {
+                throw std::invalid_argument("metrics_ring_writer: capacity must be between 1 and 2^32-1");
+            }
+            shared_memory_object::remove(_name.c_str());
+            shared_memory_object shm(create_only, _name.c_str(), read_write);
+            shm.truncate(detail::metrics_segment_size(capacity));
+            mapped_region(shm, read_write).swap(_region);
+
+            _header = new (_region.get_address()) metrics_ring_header();
+            _header->version = 1;
+            _header->capacity = static_cast<boost::uint32_t>(capacity);
+            _header->count.store(0);
+            _slots = reinterpret_cast<metrics_ring_slot*>(_header+1);
+            for(std::size_t i=0; i<capacity; ++i) {
+                new (&_slots[i]) metrics_ring_slot();
+                _slots[i].seq.store(0);
+            }
+            // publish the magic last, so that readers never see a half-built segment:
+            std::memcpy(_header->magic, detail::metrics_magic(), 8);
+            boost::atomic_thread_fence(boost::memory_order_release);
+        }
+
+        //! Destructor; removes the segment.
+        ~metrics_ring_writer() {
+            boost::interprocess::shared_memory_object::remove(_name.c_str());
+        }
+
+        //! Append r to the ring, overwriting the oldest record if the ring is full.
+        void write(const metrics_record& r) {
+            boost::uint64_t n=_header->count.load(boost::memory_order_relaxed);
+            metrics_ring_slot& s=_slots[n % _header->capacity];
+            boost::uint64_t seq=s.seq.load(boost::memory_order_relaxed);
+            s.seq.store(seq+1, boost::memory_order_relaxed);
+            boost::atomic_thread_fence(boost::memory_order_release);
+            s.rec = r;
+            s.seq.store(seq+2, boost::memory_order_release);
+            _header->count.store(n+1, boost::memory_order_release);
+        }
+
+    protected:
+        std::string _name; //!< Name of the shared memory segment.
+        boost::interprocess::mapped_region _region; //!< Mapped segment.
+        metrics_ring_header* _header; //!< Segment header.
+        metrics_ring_slot* _slots; //!< First slot.
+    };
+
+    /*! Attaches read-only to a shared-memory metrics ring.
+     */
+    class metrics_ring_reader : boost::noncopyable {
+    public:
+        /*! Constructor; throws if the segment does not exist, is not a metrics
+         ring, or is smaller than its header says it is.
+         */
+        metrics_ring_reader(const std::string& name) {
+            using namespace boost::interprocess;
+            shared_memory_object shm(open_only, name.c_str(), read_only);
+            // check the size of the segment before mapping it, since touching
+            // pages past its end would fault:
+            offset_t size=0;
+            if(!shm.get_size(size) || (size < static_cast<offset_t>(sizeof(metrics_ring_header)))) {
+                throw std::runtime_error("metrics_ring_reader: segment too small: " + name);
+            }
+            mapped_region(shm, read_only).swap(_region);
+            _header = static_cast<const metrics_ring_header*>(_region.get_address());
+            if(std::memcmp(_header->magic, detail::metrics_magic(), 8) != 0) {
+                throw std::runtime_error("metrics_ring_reader: not a metrics segment: " + name);
+            }
+            if(_header->version != 1) {
+                throw std::runtime_error("metrics_ring_reader: unsupported version: " + name);
+            }
+            if(_header->capacity == 0) {
+                throw std::runtime_error("metrics_ring_reader: segment has no slots: " + name);
+            }
+            if((static_cast<boost::uint64_t>(size) < detail::metrics_segment_size(_header->capacity))
+               || (_region.get_size() < detail::metrics_segment_size(_header->capacity))) {
+                throw std::runtime_error("metrics_ring_reader: segment smaller than its capacity: " + name);
+            }
+            _slots = reinterpret_cast<const metrics_ring_slot*>(_header+1);
+        }
+
+        //! Returns the total number of records written so far.
+        boost::uint64_t count() const {
+            return _header->count.load(boost::memory_order_acquire);
+        }
+
+        /*! Copy up to the last n records, oldest first, into out.
+
+         Records that are overwritten while being copied are skipped.
+         */
+        void last(std::size_t n, std::vector<metrics_record>& out) const {
+            out.clear();
+            boost::uint64_t end=count();
+            boost::uint64_t begin=0;
+            std::size_t cap=std::min<std::size_t>(n, _header->capacity);
+            if(end > cap) {
+                begin = end - cap;
+            }
+            for(boost::uint64_t i=begin; i<end; ++i) {
+                metrics_record r;
+                if(read(i, r)) {
+                    out.push_back(r);
+                }
+            }
+        }
+
+        //! Read the i'th record ever written; returns false if it is unavailable.
+        bool read(boost::uint64_t i, metrics_record& r) const {
+            const metrics_ring_slot& s=_slots[i % _header->capacity];
+            // the i'th record is the (i/capacity)'th write to this slot:
+            boost::uint64_t expected=2 * (i / _header->capacity + 1);
+            boost::uint64_t before=s.seq.load(boost::memory_order_acquire);
+            if(before != expected) {
+                return false;
+            }
+            std::memcpy(&r, &s.rec, sizeof(r));
+            boost::atomic_thread_fence(boost::memory_order_acquire);
+            return s.seq.load(boost::memory_order_relaxed) == before;
+        }
+
+    protected:
+        boost::interprocess::mapped_region _region; //!< Mapped segment.
+        const metrics_ring_header* _header; //!< Segment header.
+        const metrics_ring_slot* _slots; //!< First slot.
+    };
+
+} // ealib
+
+#endif
@@ -0,0 +1,307 @@
+/* lod_stream.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_LOD_STREAM_H_
+#define _EA_LOD_STREAM_H_
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <ea/events.h>
+#include <ea/datafile.h>
+#include <ea/line_of_descent.h>
+#include <ea/analysis/tool.h>
+
+/* The line of descent written by lod_event is a single serialized archive, which
+ means that it has to be completely deserialized (lod_load) before any analysis
+ can be done on it.  For long runs, this doesn't fit in memory.
+
+ The classes here write the line of descent as a flat, record-per-line stream
+ ("lod_stream.dat"), ordered from the oldest ancestor to the most recent one, and
+ provide an analysis tool that reads that stream one record at a time.  The
+ analysis only ever holds the current and previous records, so it runs in memory
+ proportional to the size of a single genome, regardless of the length of the
+ line of descent.
+
+ Each record in the stream has the format:
+
+     generation update fitness size site_0 site_1 ... site_{size-1}
+ */
+
+namespace ealib {
+
+    LIBEA_MD_DECL(LOD_STREAM_FILE, "ea.analysis.lod_stream.input", std::string);
+    LIBEA_MD_DECL(LOD_STREAM_MAX_DISTANCE, "ea.analysis.lod_stream.max_distance", unsigned int);
+
+    namespace datafiles {
+
+        /*! Writes the line of descent to a record-per-line stream at the end of
+         each epoch.
+         */
+        template <typename EA>
+        struct lod_stream : end_of_epoch_event<EA> {
+            lod_stream(EA& ea) : end_of_epoch_event<EA>(ea) {
+            }
+
+            virtual ~lod_stream() {
+            }
+
+            virtual void operator()(EA& ea) {
+                std::ofstream out("lod_stream.dat");
+
+                typename EA::lod_type::iterator i=lod_begin(ea);
+                // skip the default-constructed ancestor:
+                ++i;
+                for( ; i!=lod_end(ea); ++i) {
+                    write_record(*i, out, ea);
+                }
+            }
+
+            //! Write a single LOD record to out.
+            template <typename Individual>
+            void write_record(Individual& ind, std::ostream& out, EA& ea) {
+                out << get<IND_GENERATION>(ind) << " "
+                << get<IND_BIRTH_UPDATE>(ind) << " "
+                << static_cast<double>(ealib::fitness(ind,ea)) << " "
+                << ind.repr().size();
+                for(typename EA::representation_type::iterator j=ind.repr().begin(); j!=ind.repr().end(); ++j) {
+                    out << " " << *j;
+                }
+                out << "\n";
+            }
+        };
+
+    } // datafiles
+
+    namespace analysis {
+
+        /*! A single record read from a LOD stream.
+         */
+        template <typename T>
+        struct lod_record {
+            lod_record() : generation(0.0), update(0), fitness(0.0) {
+            }
+
+            /*! Parse a record from line; returns false if line is malformed (its
+             header can't be read, or its genome is shorter than its size), in
+             which case this record's contents are unspecified.
+             */
+            bool parse(const std::string& line) {
+                std::istringstream in(line);
+                std::size_t size=0;
+                if(!(in >> generation >> update >> fitness >> size)) {
+                    return false;
+                }
+                // reuse the existing capacity; this is the only per-record storage:
+                genome.resize(size);
+                for(std::size_t i=0; i<size; ++i) {
+                    if(!(in >> genome[i])) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            double generation;
+            long update;
+            double fitness;
+            std::vector<T> genome;
+        };
+
+        namespace detail {
+
+            /*! Returns the edit distance between x[0,nx) and y[0,ny) if it is at
+             most t, or t+1 otherwise.  Only the cells of the dynamic program
+             within t of the diagonal are computed (Ukkonen), so this takes
+             O((nx+ny)*t) time and O(t) memory.
+             */
+            template <typename T>
+            std::size_t banded_distance(const T* x, std::size_t nx, const T* y, std::size_t ny, std::size_t t) {
+                const std::size_t inf=t+1;
+                const std::size_t w=2*t+1;
+                // row[k] holds the distance between x[0,i) and y[0,j), where k=i+t-j:
+                std::vector<std::size_t> prev(w, inf), curr(w, inf);
+                for(std::size_t i=0; i<=std::min(nx, t); ++i) {
+                    prev[i+t] = i;
+                }
+                for(std::size_t j=1; j<=ny; ++j) {
+                    std::fill(curr.begin(), curr.end(), inf);
+                    std::size_t lo=(j > t) ? (j-t) : 0;
+                    std::size_t hi=std::min(nx, j+t);
+                    std::size_t rowmin=inf;
+                    for(std::size_t i=lo; i<=hi; ++i) {
+                        std::size_t k=i+t-j;
+                        std::size_t v=j;
+                        if(i > 0) {
+                            v = prev[k] + ((x[i-1] == y[j-1]) ? 0 : 1);
+                            if(k > 0) {
+                                v = std::min(v, curr[k-1] + 1);
+                            }
+                        }
+                        if(k+1 < w) {
+                            v = std::min(v, prev[k+1] + 1);
+                        }
+                        curr[k] = std::min(v, inf);
+                        rowmin = std::min(rowmin, curr[k]);
+                    }
+                    if(rowmin >= inf) {
+                        return inf;
+                    }
+                    std::swap(prev, curr);
+                }
+                if(nx+t < ny) {
+                    return inf;
+                }
+                std::size_t k=nx+t-ny;
+                return (k < w) ? prev[k] : inf;
+            }
+
+        } // detail
+
+        /*! Calculates the number of mutations between genomes a and b into d;
+         returns false if there are more than max_d.
+
+         Genomes of the same length are assumed to differ only by substitutions,
+         and d is the number of sites at which they differ; this takes one scan,
+         and is never capped.  Genomes of different lengths are compared by edit
+         (Levenshtein) distance, so that an insertion or deletion counts as one
+         mutation rather than as a change to every site after it.  The band of
+         the edit distance is doubled from the difference in length until it
+         holds the distance or reaches max_d, which takes O((|a|+|b|)*d) time.
+         */
+        template <typename T>
+        bool genome_distance(const std::vector<T>& a, const std::vector<T>& b, std::size_t max_d, std::size_t& d) {
+            if(a.size() == b.size()) {
+                d = 0;
+                for(std::size_t i=0; i<a.size(); ++i) {
+                    if(a[i] != b[i]) {
+                        ++d;
+                    }
+                }
+                return true;
+            }
+
+            // the common prefix and suffix don't change the distance:
+            std::size_t p=0;
+            while((p < a.size()) && (p < b.size()) && (a[p] == b[p])) {
+                ++p;
+            }
+            std::size_t na=a.size(), nb=b.size();
+            while((na > p) && (nb > p) && (a[na-1] == b[nb-1])) {
+                --na;
+                --nb;
+            }
+            na -= p;
+            nb -= p;
+
+            std::size_t t=std::max<std::size_t>((na > nb) ? (na-nb) : (nb-na), 1);
+            if(t > max_d) {
+                return false;
+            }
+            const T* x=na ? &a[p] : 0;
+            const T* y=nb ? &b[p] : 0;
+            for( ; ; t=std::min(2*t, max_d)) {
+                d = detail::banded_distance(x, na, y, nb, t);
+                if(d <= t) {
+                    return true;
+                } else if(t >= max_d) {
+                    return false;
+                }
+            }
+        }
+
+        /*! Streams a line of descent written by datafiles::lod_stream and
+         calculates per-generation fitness, mutation counts and genome deltas.
+         Mutations are counted from the previous genome by genome_distance, up
+         to LOD_STREAM_MAX_DISTANCE (default 1000); larger distances are written
+         as "NA".  The change in genome size is reported separately.
+
+         Records are read, analyzed, and written one at a time, so memory usage
+         is independent of the length of the line of descent.  Malformed lines
+         are skipped, and the number skipped is reported when the analysis is
+         done.
+         */
+        LIBEA_ANALYSIS_TOOL(lod_stream_analysis) {
+            typedef lod_record<typename EA::representation_type::value_type> record_type;
+
+            std::ifstream in(get<LOD_STREAM_FILE>(ea).c_str());
+            if(!in.good()) {
+                throw std::runtime_error("lod_stream_analysis: could not open " + get<LOD_STREAM_FILE>(ea));
+            }
+
+            datafile df("lod_stream_analysis.dat");
+            df.add_field("generation")
+            .add_field("update")
+            .add_field("fitness")
+            .add_field("fitness_delta")
+            .add_field("mutations")
+            .add_field("size")
+            .add_field("size_delta");
+
+            const std::size_t max_d=get<LOD_STREAM_MAX_DISTANCE>(ea, 1000);
+            record_type prev, curr;
+            std::string line;
+            bool first=true;
+            std::size_t lineno=0, skipped=0;
+            while(std::getline(in, line)) {
+                ++lineno;
+                if(line.find_first_not_of(" \t\r") == std::string::npos) {
+                    continue;
+                }
+                if(!curr.parse(line)) {
+                    ++skipped;
+                    continue;
+                }
+
+                if(first) {
+                    prev = curr;
+                    first = false;
+                }
+
+                df.write(curr.generation)
+                .write(curr.update)
+                .write(curr.fitness)
+                .write(curr.fitness - prev.fitness);
+                std::size_t d=0;
+                if(genome_distance(prev.genome, curr.genome, max_d, d)) {
+                    df.write(d);
+                } else {
+                    df.write("NA");
+                }
+                df.write(curr.genome.size())
+                .write(static_cast<long>(curr.genome.size()) - static_cast<long>(prev.genome.size()))
+                .endl();
+
+                std::swap(prev, curr);
+            }
+
+            if(skipped > 0) {
+                std::cerr << "lod_stream_analysis: skipped " << skipped << " malformed line(s) of "
+                << lineno << " in " << get<LOD_STREAM_FILE>(ea) << std::endl;
+            }
+        }
+
+    } // analysis
+} // ealib
+
+#endif
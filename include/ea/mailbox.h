@@ -0,0 +1,295 @@
+/* mailbox.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_MAILBOX_H_
+#define _EA_MAILBOX_H_
+
+#include <cstddef>
+#include <string>
+#include <stdexcept>
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/serialization/nvp.hpp>
+#include <boost/serialization/split_member.hpp>
+#include <boost/serialization/vector.hpp>
+
+namespace ealib {
+
+    //! What a mailbox does with a message that arrives when it is full.
+    enum mailbox_overflow {
+        DROP_NEWEST, //!< The arriving message is dropped.
+        DROP_OLDEST //!< The oldest queued message is dropped to make room.
+    };
+
+    //! Returns the overflow policy named s ("drop_newest" or "drop_oldest").
+    inline mailbox_overflow make_mailbox_overflow(const std::string& s) {
+        if(s == "drop_newest") {
+            return DROP_NEWEST;
+        } else if(s == "drop_oldest") {
+            return DROP_OLDEST;
+        }
+        throw std::invalid_argument("unknown mailbox overflow policy: " + s);
+    }
+
+    /*! A fixed number of bounded, lock-free mailboxes, stored contiguously.
+
+     Each mailbox is a ring of slots, each with its own sequence number (Vyukov's
+     bounded queue), so that any number of threads may deliver to a mailbox at
+     once while its owner reads from it, with no locks and no allocation after
+     construction.  Mailbox i occupies slots [i*capacity, (i+1)*capacity) of a
+     single array, and the positions of each mailbox are kept on their own cache
+     lines.  Capacity is rounded up to a power of two.
+
+     Each mailbox also has an owner, a nonzero tag naming its reader.  When
+     the reader changes, claim() discards the messages delivered before the
+     change, but none delivered after it, so the new reader sees only messages
+     meant for it.
+
+     A mailbox_array may be serialized (for a checkpoint) while no thread is
+     using it.
+     */
+    template <typename T>
+    class mailbox_array {
+    public:
+        //! Constructor.
+        mailbox_array(std::size_t n, std::size_t capacity, mailbox_overflow overflow=DROP_NEWEST)
+        : _n(n), _overflow(overflow), _boxes(new box[n]) {
+            std::size_t c=1;
+            while(c < capacity) {
+                c <<= 1;
+            }
+            _mask = c - 1;
+            _slots.reset(new slot[n * c]);
+            for(std::size_t i=0; i<n; ++i) {
+                for(std::size_t j=0; j<c; ++j) {
+                    _slots[i*c + j].seq.store(j, boost::memory_order_relaxed);
+                }
+            }
+        }
+
+        //! Returns the number of mailboxes.
+        std::size_t size() const {
+            return _n;
+        }
+
+        //! Returns the capacity of each mailbox.
+        std::size_t capacity() const {
+            return _mask + 1;
+        }
+
+        /*! Deliver t to mailbox i; returns false if it was dropped.  May be
+         called from any thread.
+         */
+        bool push(std::size_t i, const T& t) {
+            box& b=_boxes[i];
+            for(;;) {
+                std::size_t pos=b.tail.load(boost::memory_order_relaxed);
+                for(;;) {
+                    slot& s=_slots[i*capacity() + (pos & _mask)];
+                    std::ptrdiff_t diff=static_cast<std::ptrdiff_t>(s.seq.load(boost::memory_order_acquire)) - static_cast<std::ptrdiff_t>(pos);
+                    if(diff == 0) {
+                        if(b.tail.compare_exchange_weak(pos, pos+1, boost::memory_order_relaxed)) {
+                            s.value = t;
+                            s.seq.store(pos+1, boost::memory_order_release);
+                            return true;
+                        }
+                    } else if(diff < 0) {
+                        break; // full
+                    } else {
+                        pos = b.tail.load(boost::memory_order_relaxed);
+                    }
+                }
+                T oldest;
+                if(_overflow == DROP_NEWEST || !pop(i, oldest)) {
+                    b.dropped.fetch_add(1, boost::memory_order_relaxed);
+                    return false;
+                }
+                b.dropped.fetch_add(1, boost::memory_order_relaxed);
+            }
+        }
+
+        /*! Pop the oldest message in mailbox i into t; returns false if it is
+         empty.  Should be called only by the mailbox's owner (it is also
+         called by producers to make room under DROP_OLDEST, which is safe).
+         */
+        bool pop(std::size_t i, T& t) {
+            box& b=_boxes[i];
+            std::size_t pos=b.head.load(boost::memory_order_relaxed);
+            for(;;) {
+                slot& s=_slots[i*capacity() + (pos & _mask)];
+                std::ptrdiff_t diff=static_cast<std::ptrdiff_t>(s.seq.load(boost::memory_order_acquire)) - static_cast<std::ptrdiff_t>(pos+1);
+                if(diff == 0) {
+                    if(b.head.compare_exchange_weak(pos, pos+1, boost::memory_order_relaxed)) {
+                        t = s.value;
+                        s.seq.store(pos + _mask + 1, boost::memory_order_release);
+                        return true;
+                    }
+                } else if(diff < 0) {
+                    return false; // empty
+                } else {
+                    pos = b.head.load(boost::memory_order_relaxed);
+                }
+            }
+        }
+
+        //! Discard all messages in mailbox i.
+        void clear(std::size_t i) {
+            T t;
+            while(pop(i, t)) {
+            }
+        }
+
+        //! Returns the owner tag of mailbox i (0 if it has never been claimed).
+        boost::uint64_t owner(std::size_t i) const {
+            return _boxes[i].owner.load();
+        }
+
+        /*! Make o the owner of mailbox i, if it is not already, discarding the
+         messages delivered to the previous owner.  May be called from any
+         thread, by readers and senders alike.
+
+         Only messages at positions before the tail at the time of the change
+         are discarded: anyone who delivers to o has first seen o as the owner,
+         and so delivers after the change, and its message is kept.
+         */
+        void claim(std::size_t i, boost::uint64_t o) {
+            box& b=_boxes[i];
+            boost::uint64_t prev=b.owner.load();
+            if(prev == o) {
+                return;
+            }
+            std::size_t end=b.tail.load();
+            if(b.owner.compare_exchange_strong(prev, o)) {
+                T t;
+                while(static_cast<std::ptrdiff_t>(end - b.head.load()) > 0 && pop(i, t)) {
+                }
+            }
+        }
+
+        //! Returns the number of messages ever delivered to mailbox i.
+        boost::uint64_t delivered(std::size_t i) const {
+            return _boxes[i].tail.load(boost::memory_order_relaxed);
+        }
+
+        //! Returns the number of messages ever dropped by mailbox i.
+        boost::uint64_t dropped(std::size_t i) const {
+            return _boxes[i].dropped.load(boost::memory_order_relaxed);
+        }
+
+    protected:
+        friend class boost::serialization::access;
+
+        //! Serialize the messages, owner, and counts of every mailbox.
+        template <class Archive>
+        void save(Archive& ar, const unsigned int version) const {
+            std::vector<T> msgs;
+            std::vector<boost::uint64_t> owners, tails, counts, dropped;
+            for(std::size_t i=0; i<_n; ++i) {
+                const box& b=_boxes[i];
+                std::size_t head=b.head.load(), tail=b.tail.load();
+                for(std::size_t pos=head; pos!=tail; ++pos) {
+                    msgs.push_back(_slots[i*capacity() + (pos & _mask)].value);
+                }
+                owners.push_back(b.owner.load());
+                tails.push_back(tail);
+                counts.push_back(tail - head);
+                dropped.push_back(b.dropped.load());
+            }
+            ar & boost::serialization::make_nvp("owners", owners);
+            ar & boost::serialization::make_nvp("tails", tails);
+            ar & boost::serialization::make_nvp("counts", counts);
+            ar & boost::serialization::make_nvp("dropped", dropped);
+            ar & boost::serialization::make_nvp("messages", msgs);
+        }
+
+        /*! Deserialize the mailboxes; they must already have the same number
+         and capacity as those saved.  Positions are restored as they were, so
+         that delivered() counts continue from the checkpoint.
+         */
+        template <class Archive>
+        void load(Archive& ar, const unsigned int version) {
+            std::vector<T> msgs;
+            std::vector<boost::uint64_t> owners, tails, counts, dropped;
+            ar & boost::serialization::make_nvp("owners", owners);
+            ar & boost::serialization::make_nvp("tails", tails);
+            ar & boost::serialization::make_nvp("counts", counts);
+            ar & boost::serialization::make_nvp("dropped", dropped);
+            ar & boost::serialization::make_nvp("messages", msgs);
+            if(owners.size() != _n) {
+                throw std::runtime_error("mailbox_array: checkpoint has a different number of mailboxes");
+            }
+            std::size_t k=0;
+            for(std::size_t i=0; i<_n; ++i) {
+                if(counts[i] > capacity()) {
+                    throw std::runtime_error("mailbox_array: checkpoint has a different mailbox capacity");
+                }
+                std::size_t tail=static_cast<std::size_t>(tails[i]);
+                std::size_t head=tail - static_cast<std::size_t>(counts[i]);
+                // slots at [head,tail) hold the saved messages; the rest are free:
+                for(std::size_t pos=head; pos!=head+capacity(); ++pos) {
+                    slot& s=_slots[i*capacity() + (pos & _mask)];
+                    if(static_cast<std::ptrdiff_t>(tail - pos) > 0) {
+                        s.value = msgs.at(k++);
+                        s.seq.store(pos+1);
+                    } else {
+                        s.value = T();
+                        s.seq.store(pos);
+                    }
+                }
+                box& b=_boxes[i];
+                b.head.store(head);
+                b.tail.store(tail);
+                b.owner.store(owners[i]);
+                b.dropped.store(dropped[i]);
+            }
+        }
+
+        BOOST_SERIALIZATION_SPLIT_MEMBER();
+
+        //! A slot of a mailbox.
+        struct slot {
+            boost::atomic<std::size_t> seq; //!< Sequence number.
+            T value; //!< Message.
+        };
+
+        //! Positions of a mailbox.
+        struct box {
+            box() : head(0), tail(0), owner(0), dropped(0) {
+            }
+
+            boost::atomic<std::size_t> head; //!< Next position to read.
+            char _pad0[64];
+            boost::atomic<std::size_t> tail; //!< Next position to write.
+            boost::atomic<boost::uint64_t> owner; //!< Tag of the mailbox's reader.
+            boost::atomic<boost::uint64_t> dropped; //!< Messages dropped.
+            char _pad1[64];
+        };
+
+        std::size_t _n; //!< Number of mailboxes.
+        std::size_t _mask; //!< Index mask (capacity-1).
+        mailbox_overflow _overflow; //!< Overflow policy.
+        boost::scoped_array<box> _boxes; //!< Positions of each mailbox.
+        boost::scoped_array<slot> _slots; //!< Slots of all mailboxes.
+    };
+
+} // ealib
+
+#endif
@@ -0,0 +1,150 @@
+/* memory_accounting.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_MEMORY_ACCOUNTING_H_
+#define _EA_MEMORY_ACCOUNTING_H_
+
+#include <cstddef>
+#include <boost/cstdint.hpp>
+#include <boost/atomic.hpp>
+
+/* Allocator-level accounting of the memory held by each part of an EA.
+
+ When LIBEA_MEMORY_ACCOUNTING is defined, src/memory_accounting.cpp replaces the
+ global operator new and delete.  Every allocation is charged to the component
+ that is current on the allocating thread, and every deallocation is credited
+ back to the component that was charged for it, no matter where it is freed.
+ The current component is set with a scope, e.g.:
+
+     LIBEA_MEMORY_SCOPE(ealib::memory::NETWORKS);
+
+ The profiled<> component wrappers set these scopes for recombination
+ (OFFSPRING), mutation (GENOMES) and fitness evaluation (NETWORKS), and
+ accounted_lod_event sets one for line-of-descent links (ATTRIBUTES).  Storage
+ drawn from a buffer_pool, i.e., the chunks of every chunked_genome, is charged
+ to GENOMES when it is allocated, wherever that happens, and the async_datafile
+ charges its buffers to DATAFILES.  Anything else is OTHER.
+
+ When LIBEA_MEMORY_ACCOUNTING is not defined, scopes expand to nothing and all
+ counters read as zero.
+ */
+
+namespace ealib {
+    namespace memory {
+
+        //! Components to which memory is charged.
+        enum component {
+            OTHER=0,
+            OFFSPRING, //!< Individuals and their meta-data, made during reproduction.
+            GENOMES, //!< Pooled genome storage, and genome growth during mutation.
+            ATTRIBUTES, //!< Line-of-descent links.
+            NETWORKS, //!< Temporaries of fitness evaluation (e.g., decoded networks).
+            DATAFILES, //!< Datafile buffers.
+            NCOMPONENTS
+        };
+
+        //! Live and peak byte counts for each component.
+        struct counters {
+            counters() {
+                for(std::size_t i=0; i<NCOMPONENTS; ++i) {
+                    live[i].store(0);
+                    peak[i].store(0);
+                }
+            }
+
+            boost::atomic<boost::int64_t> live[NCOMPONENTS];
+            boost::atomic<boost::int64_t> peak[NCOMPONENTS];
+        };
+
+        //! Returns the process-wide counters.
+        inline counters& global_counters() {
+            static counters c;
+            return c;
+        }
+
+        //! Returns a reference to the current component of the calling thread.
+        inline int& current_component() {
+            static __thread int c=OTHER;
+            return c;
+        }
+
+        //! Charge n bytes to component c.
+        inline void charge(int c, boost::int64_t n) {
+            counters& k=global_counters();
+            boost::int64_t now=k.live[c].fetch_add(n, boost::memory_order_relaxed) + n;
+            boost::int64_t p=k.peak[c].load(boost::memory_order_relaxed);
+            while(now > p && !k.peak[c].compare_exchange_weak(p, now, boost::memory_order_relaxed)) {
+            }
+        }
+
+        //! Credit n bytes back to component c.
+        inline void credit(int c, boost::int64_t n) {
+            global_counters().live[c].fetch_sub(n, boost::memory_order_relaxed);
+        }
+
+        //! Returns the number of bytes currently held by component c.
+        inline boost::int64_t live_bytes(component c) {
+            return global_counters().live[c].load(boost::memory_order_relaxed);
+        }
+
+        //! Returns the peak number of bytes held by component c since the last reset_peak(c).
+        inline boost::int64_t peak_bytes(component c) {
+            return global_counters().peak[c].load(boost::memory_order_relaxed);
+        }
+
+        //! Reset the peak of component c to its current live value.
+        inline void reset_peak(component c) {
+            counters& k=global_counters();
+            k.peak[c].store(k.live[c].load(boost::memory_order_relaxed), boost::memory_order_relaxed);
+        }
+
+        //! Returns the total number of bytes currently held by all components.
+        inline boost::int64_t total_bytes() {
+            boost::int64_t t=0;
+            for(std::size_t i=0; i<NCOMPONENTS; ++i) {
+                t += live_bytes(static_cast<component>(i));
+            }
+            return t;
+        }
+
+        /*! Charges all allocations made by the calling thread during its lifetime
+         to component c.
+         */
+        struct scope {
+            scope(component c) : _prev(current_component()) {
+                current_component() = c;
+            }
+
+            ~scope() {
+                current_component() = _prev;
+            }
+
+            int _prev;
+        };
+
+    } // memory
+} // ealib
+
+#ifdef LIBEA_MEMORY_ACCOUNTING
+#define LIBEA_MEMORY_SCOPE(c) ealib::memory::scope _libea_memory_scope(c)
+#else
+#define LIBEA_MEMORY_SCOPE(c)
+#endif
+
+#endif
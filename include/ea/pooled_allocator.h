@@ -0,0 +1,221 @@
+/* pooled_allocator.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_POOLED_ALLOCATOR_H_
+#define _EA_POOLED_ALLOCATOR_H_
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <vector>
+#include <boost/thread/tss.hpp>
+#include <ea/memory_accounting.h>
+
+namespace ealib {
+
+    /*! A per-thread pool of recycled memory blocks, kept in size-classed
+     freelists.
+
+     Blocks of up to min_block bytes go straight to operator new.  Larger
+     requests are rounded up to one of four size classes per power of two (so at
+     most 25% of a block is slack), and freed blocks are kept on the freelist of
+     their class instead of being returned to the heap, up to max_cached bytes in
+     total.  In a population of roughly constant size, the genome buffers freed
+     by deaths are thus handed straight to the offspring born next.
+
+     Pools are per-thread, and so need no locking; a block freed on a thread
+     other than the one that allocated it simply joins that thread's pool.  A
+     thread's pool, and the blocks cached in it, are freed when the thread
+     exits.  Pools hold genome storage, and so their blocks, including those
+     cached for reuse, are charged to memory::GENOMES.
+     */
+    class buffer_pool {
+    public:
+        enum {
+            min_block=256, //!< Blocks of this size or smaller are not pooled.
+            min_shift=8, //!< log2(min_block).
+            nclasses=4*(sizeof(std::size_t)*8 - min_shift)
+        };
+
+        //! Constructor.
+        buffer_pool() : _free(nclasses), _cached(0), _max_cached(std::size_t(1) << 28) {
+        }
+
+        //! Destructor; returns all cached blocks to the heap.
+        ~buffer_pool() {
+            for(std::size_t i=0; i<_free.size(); ++i) {
+                for(std::size_t j=0; j<_free[i].size(); ++j) {
+                    ::operator delete(_free[i][j]);
+                }
+            }
+        }
+
+        //! Returns the calling thread's pool.
+        static buffer_pool& local() {
+            // never destroyed, so that genomes freed during static destruction
+            // still find their pool:
+            static boost::thread_specific_ptr<buffer_pool>* pools=new boost::thread_specific_ptr<buffer_pool>();
+            buffer_pool* p=pools->get();
+            if(p == 0) {
+                p = new buffer_pool();
+                pools->reset(p);
+            }
+            return *p;
+        }
+
+        //! Allocate a block of at least n bytes.
+        void* allocate(std::size_t n) {
+            LIBEA_MEMORY_SCOPE(memory::GENOMES);
+            if(n <= min_block) {
+                return ::operator new(n);
+            }
+            std::size_t rounded;
+            std::size_t c=size_class(n, rounded);
+            if(!_free[c].empty()) {
+                void* p=_free[c].back();
+                _free[c].pop_back();
+                _cached -= rounded;
+                return p;
+            }
+            return ::operator new(rounded);
+        }
+
+        //! Return a block of n bytes (as passed to allocate) to the pool.
+        void deallocate(void* p, std::size_t n) {
+            if(n <= min_block) {
+                ::operator delete(p);
+                return;
+            }
+            std::size_t rounded;
+            std::size_t c=size_class(n, rounded);
+            if(_cached + rounded > _max_cached) {
+                ::operator delete(p);
+                return;
+            }
+            _free[c].push_back(p);
+            _cached += rounded;
+        }
+
+        //! Returns the number of bytes held in freelists.
+        std::size_t cached_bytes() const {
+            return _cached;
+        }
+
+        //! Set the maximum number of bytes held in freelists.
+        void max_cached_bytes(std::size_t n) {
+            _max_cached = n;
+        }
+
+        /*! Returns the size class of an n-byte request (n > min_block), and
+         sets rounded to the size of blocks in that class.
+         */
+        static std::size_t size_class(std::size_t n, std::size_t& rounded) {
+            std::size_t m=n-1, h=0;
+            while((m >> (h+1)) != 0) {
+                ++h;
+            }
+            // 2^h <= m < 2^(h+1); split that range into four classes:
+            std::size_t step=std::size_t(1) << (h-2);
+            std::size_t q=m / step;
+            rounded = (q + 1) * step;
+            return (h - min_shift) * 4 + (q - 4);
+        }
+
+    protected:
+        std::vector<std::vector<void*> > _free; //!< Freelist for each size class.
+        std::size_t _cached; //!< Bytes held in freelists.
+        std::size_t _max_cached; //!< Maximum bytes held in freelists.
+
+    private:
+        buffer_pool(const buffer_pool&);
+        buffer_pool& operator=(const buffer_pool&);
+    };
+
+
+    /*! Standard allocator that draws its memory from the calling thread's
+     buffer_pool.  All pooled_allocators are interchangeable.
+     */
+    template <typename T>
+    class pooled_allocator {
+    public:
+        typedef T value_type;
+        typedef T* pointer;
+        typedef const T* const_pointer;
+        typedef T& reference;
+        typedef const T& const_reference;
+        typedef std::size_t size_type;
+        typedef std::ptrdiff_t difference_type;
+
+        template <typename U>
+        struct rebind {
+            typedef pooled_allocator<U> other;
+        };
+
+        pooled_allocator() {
+        }
+
+        template <typename U>
+        pooled_allocator(const pooled_allocator<U>&) {
+        }
+
+        pointer address(reference x) const {
+            return &x;
+        }
+
+        const_pointer address(const_reference x) const {
+            return &x;
+        }
+
+        pointer allocate(size_type n, const void* =0) {
+            if(n > max_size()) {
+                throw std::bad_alloc();
+            }
+            return static_cast<pointer>(buffer_pool::local().allocate(n * sizeof(T)));
+        }
+
+        void deallocate(pointer p, size_type n) {
+            buffer_pool::local().deallocate(p, n * sizeof(T));
+        }
+
+        size_type max_size() const {
+            return std::numeric_limits<size_type>::max() / sizeof(T);
+        }
+
+        void construct(pointer p, const T& x) {
+            new(p) T(x);
+        }
+
+        void destroy(pointer p) {
+            p->~T();
+        }
+    };
+
+    template <typename T, typename U>
+    bool operator==(const pooled_allocator<T>&, const pooled_allocator<U>&) {
+        return true;
+    }
+
+    template <typename T, typename U>
+    bool operator!=(const pooled_allocator<T>&, const pooled_allocator<U>&) {
+        return false;
+    }
+
+} // ealib
+
+#endif
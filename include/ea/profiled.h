@@ -0,0 +1,165 @@
+/* profiled.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_PROFILED_H_
+#define _EA_PROFILED_H_
+
+#include <ea/profiling.h>
+#include <ea/memory_accounting.h>
+#include <ea/island_model.h>
+#include <ea/line_of_descent.h>
+#include <ea/batch_fitness.h>
+
+/* Wrappers that add phase timing to existing EA components, without changing
+ the components themselves.  For example:
+
+     generational_models::steady_state<
+         selection::profiled<selection::proportionate< > >,
+         selection::profiled<selection::tournament< >, profiling::REPLACEMENT> >
+
+ times parent selection and replacement inside the steady-state model.  The
+ recombination, mutation and fitness wrappers also set the memory accounting
+ scope (see ea/memory_accounting.h) for the component they wrap.  When neither
+ LIBEA_PROFILING nor LIBEA_MEMORY_ACCOUNTING is defined, each wrapper simply
+ forwards to the component it wraps.
+ */
+
+namespace ealib {
+
+    namespace selection {
+
+        /*! Times a selection strategy; phase P distinguishes selection of parents
+         from selection of survivors (replacement).
+         */
+        template <typename Selection, profiling::phase P=profiling::SELECTION>
+        struct profiled : profiling::construction_timer<P>, Selection {
+            template <typename Population, typename EA>
+            profiled(std::size_t n, Population& src, EA& ea) : Selection(n, src, ea) {
+                this->stop();
+            }
+
+            template <typename Population, typename EA>
+            void operator()(Population& src, Population& dst, std::size_t n, EA& ea) {
+                LIBEA_PROFILE_SCOPE(P);
+                Selection::operator()(src, dst, n, ea);
+            }
+        };
+
+    } // selection
+
+    namespace recombination {
+
+        //! Times a recombination operator.
+        template <typename Recombination>
+        struct profiled : Recombination {
+            template <typename Population, typename EA>
+            void operator()(Population& parents, Population& offspring, EA& ea) {
+                LIBEA_PROFILE_SCOPE(profiling::RECOMBINATION);
+                LIBEA_MEMORY_SCOPE(memory::OFFSPRING);
+                Recombination::operator()(parents, offspring, ea);
+            }
+        };
+
+    } // recombination
+
+    namespace mutation {
+
+        //! Times a mutation operator.
+        template <typename MutationOperator>
+        struct profiled : MutationOperator {
+            template <typename EA>
+            void operator()(typename EA::individual_type& ind, EA& ea) {
+                LIBEA_PROFILE_SCOPE(profiling::MUTATION);
+                LIBEA_MEMORY_SCOPE(memory::GENOMES);
+                MutationOperator::operator()(ind, ea);
+            }
+        };
+
+    } // mutation
+
+    /*! Times a fitness function.  Both the deterministic and stochastic forms of
+     the fitness function call operator are forwarded, as is the batch interface
+     (see ea/batch_fitness.h); only those that the wrapped fitness function
+     defines are ever instantiated.
+     */
+    template <typename FitnessFunction>
+    struct profiled_fitness : FitnessFunction {
+        template <typename Individual, typename EA>
+        typename FitnessFunction::fitness_type operator()(Individual& ind, EA& ea) {
+            LIBEA_PROFILE_SCOPE(profiling::FITNESS);
+            LIBEA_MEMORY_SCOPE(memory::NETWORKS);
+            return FitnessFunction::operator()(ind, ea);
+        }
+
+        template <typename Individual, typename RNG, typename EA>
+        typename FitnessFunction::fitness_type operator()(Individual& ind, RNG& rng, EA& ea) {
+            LIBEA_PROFILE_SCOPE(profiling::FITNESS);
+            LIBEA_MEMORY_SCOPE(memory::NETWORKS);
+            return FitnessFunction::operator()(ind, rng, ea);
+        }
+
+        //! Times a batch evaluation, counting one call per genome.
+        template <typename Batch, typename EA>
+        void evaluate_batch(const Batch& b, double* f, EA& ea) {
+            LIBEA_PROFILE_BATCH(profiling::FITNESS, b.size());
+            LIBEA_MEMORY_SCOPE(memory::NETWORKS);
+            FitnessFunction::evaluate_batch(b, f, ea);
+        }
+    };
+
+    //! A profiled fitness function has a batch interface only if the one it wraps does.
+    template <typename FitnessFunction>
+    struct has_batch_evaluation<profiled_fitness<FitnessFunction> > : has_batch_evaluation<FitnessFunction> {
+    };
+
+    //! Times migration between islands.
+    template <typename EA>
+    struct profiled_island_model : island_model<EA> {
+        profiled_island_model(EA& ea) : island_model<EA>(ea) {
+        }
+
+        virtual ~profiled_island_model() {
+        }
+
+        virtual void operator()(EA& ea) {
+            LIBEA_PROFILE_SCOPE(profiling::MIGRATION);
+            island_model<EA>::operator()(ea);
+        }
+    };
+
+    //! Charges the line-of-descent links made as offspring inherit to memory::ATTRIBUTES.
+    template <typename EA>
+    struct accounted_lod_event : lod_event<EA> {
+        accounted_lod_event(EA& ea) : lod_event<EA>(ea) {
+        }
+
+        virtual ~accounted_lod_event() {
+        }
+
+        virtual void operator()(typename EA::population_type& parents,
+                                typename EA::individual_type& offspring,
+                                EA& ea) {
+            LIBEA_MEMORY_SCOPE(memory::ATTRIBUTES);
+            lod_event<EA>::operator()(parents, offspring, ea);
+        }
+    };
+
+} // ealib
+
+#endif
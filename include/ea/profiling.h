@@ -0,0 +1,203 @@
+/* profiling.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_PROFILING_H_
+#define _EA_PROFILING_H_
+
+#include <boost/cstdint.hpp>
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+/* Low-overhead, built-in instrumentation of the hot paths of an EA.
+
+ Time is measured in timestamp-counter ticks around each phase of an update
+ (selection, recombination, etc.), and the number of times each phase was
+ entered is counted, e.g.:
+
+     LIBEA_PROFILE_SCOPE(ealib::profiling::FITNESS);
+
+ Time is exclusive: when one timed phase is entered from within another (e.g.,
+ fitness evaluation during selection), the ticks spent in the inner phase are
+ charged to it alone, and not also to the outer one, so that the phases of an
+ update sum to no more than its total.
+
+ All of this is compiled in only if LIBEA_PROFILING is defined; otherwise
+ LIBEA_PROFILE_SCOPE and LIBEA_PROFILE_BATCH expand to nothing, and the
+ profiled<> component wrappers reduce to plain forwarding calls that the
+ compiler inlines away.
+
+ Counters are process-wide and are not synchronized; when islands or organisms
+ are run in parallel, they are approximate.
+ */
+
+namespace ealib {
+    namespace profiling {
+
+        //! Phases of an update that are timed.
+        enum phase {
+            SELECTION=0,
+            RECOMBINATION,
+            MUTATION,
+            FITNESS,
+            REPLACEMENT,
+            MIGRATION,
+            SCHEDULER,
+            NPHASES
+        };
+
+        //! Returns the name of phase p, as used in datafile headers.
+        inline const char* phase_name(std::size_t p) {
+            static const char* names[NPHASES] = {
+                "selection", "recombination", "mutation", "fitness", "replacement", "migration", "scheduler"
+            };
+            return names[p];
+        }
+
+        //! Returns the current value of the timestamp counter.
+        inline boost::uint64_t ticks() {
+#if defined(__i386__) || defined(__x86_64__)
+            return __rdtsc();
+#else
+            timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return static_cast<boost::uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+#endif
+        }
+
+        //! Per-phase accumulated ticks and entry counts.
+        struct counters {
+            counters() {
+                reset();
+            }
+
+            void reset() {
+                for(std::size_t i=0; i<NPHASES; ++i) {
+                    ticks[i] = 0;
+                    calls[i] = 0;
+                }
+            }
+
+            boost::uint64_t ticks[NPHASES];
+            boost::uint64_t calls[NPHASES];
+        };
+
+        //! Returns the process-wide counters.
+        inline counters& global_counters() {
+            static counters c;
+            return c;
+        }
+
+        //! Returns the ticks spent in timers nested in the innermost open timer of the calling thread.
+        inline boost::uint64_t& nested_ticks() {
+            static __thread boost::uint64_t t=0;
+            return t;
+        }
+
+        /*! Measures the exclusive time of a phase: the ticks between start() and
+         stop(), less those spent in timers started and stopped in between.
+         Timers on a thread must be stopped in the reverse of the order they
+         were started.
+         */
+        struct exclusive_timer {
+            //! Start timing.
+            void start() {
+                _outer = nested_ticks();
+                nested_ticks() = 0;
+                _start = ticks();
+            }
+
+            //! Stop timing, and charge the exclusive ticks to phase p, as n calls.
+            void stop(phase p, boost::uint64_t n=1) {
+                boost::uint64_t elapsed=ticks() - _start;
+                counters& c=global_counters();
+                c.ticks[p] += elapsed - nested_ticks();
+                c.calls[p] += n;
+                nested_ticks() = _outer + elapsed;
+            }
+
+            boost::uint64_t _start; //!< Ticks when started.
+            boost::uint64_t _outer; //!< Nested ticks of the enclosing timer when started.
+        };
+
+        /*! Charges the exclusive ticks elapsed during its lifetime to phase P.
+         */
+        template <phase P>
+        struct scoped_timer : exclusive_timer {
+            scoped_timer() {
+                start();
+            }
+
+            ~scoped_timer() {
+                stop(P);
+            }
+        };
+
+        /*! Charges the exclusive ticks elapsed during its lifetime to phase P,
+         as n calls (e.g., one per genome of a batch, which may be empty).
+         */
+        template <phase P>
+        struct scoped_batch_timer : exclusive_timer {
+            scoped_batch_timer(boost::uint64_t n) : _n(n) {
+                start();
+            }
+
+            ~scoped_batch_timer() {
+                stop(P, _n);
+            }
+
+            boost::uint64_t _n; //!< Calls to charge.
+        };
+
+        /*! Base class that starts timing phase P when it is constructed, and
+         stops when stop() is called.  Useful for timing constructors, where a
+         scoped timer can't enclose the member initializer list.
+         */
+        template <phase P>
+        struct construction_timer {
+#ifdef LIBEA_PROFILING
+            construction_timer() {
+                _timer.start();
+            }
+
+            void stop() {
+                _timer.stop(P);
+            }
+
+            exclusive_timer _timer;
+#else
+            void stop() {
+            }
+#endif
+        };
+
+    } // profiling
+} // ealib
+
+#ifdef LIBEA_PROFILING
+#define LIBEA_PROFILE_SCOPE(p) ealib::profiling::scoped_timer<p> _libea_profile_timer
+#define LIBEA_PROFILE_BATCH(p, n) ealib::profiling::scoped_batch_timer<p> _libea_profile_timer(n)
+#else
+#define LIBEA_PROFILE_SCOPE(p)
+#define LIBEA_PROFILE_BATCH(p, n)
+#endif
+
+#endif
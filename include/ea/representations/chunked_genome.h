@@ -0,0 +1,474 @@
+/* chunked_genome.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_REPRESENTATIONS_CHUNKED_GENOME_H_
+#define _EA_REPRESENTATIONS_CHUNKED_GENOME_H_
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/serialization/nvp.hpp>
+#include <boost/serialization/split_member.hpp>
+#include <boost/serialization/vector.hpp>
+#include <ea/pooled_allocator.h>
+
+namespace ealib {
+
+    template <typename T, std::size_t ChunkSize> class chunked_genome;
+
+    namespace detail {
+
+        /*! Reference to a single site of a chunked_genome.  Reading a site is
+         free; assigning to it first gives the genome its own copy of the chunk
+         that holds the site, if that chunk is shared.
+         */
+        template <typename Genome>
+        class chunked_site_reference {
+        public:
+            typedef typename Genome::value_type value_type;
+
+            chunked_site_reference(Genome* g, std::size_t c, std::size_t o) : _g(g), _c(c), _o(o) {
+            }
+
+            operator value_type() const {
+                return (*_g->_chunks[_c])[_o];
+            }
+
+            chunked_site_reference& operator=(const value_type& x) {
+                _g->unshare(_c);
+                (*_g->_chunks[_c])[_o] = x;
+                return *this;
+            }
+
+            chunked_site_reference& operator=(const chunked_site_reference& that) {
+                return *this = static_cast<value_type>(that);
+            }
+
+        protected:
+            Genome* _g;
+            std::size_t _c; //!< Chunk.
+            std::size_t _o; //!< Offset within chunk.
+        };
+
+        /*! Iterator over the sites of a chunked_genome.  Sequential traversal
+         walks the chunks directly; random jumps locate the chunk by binary
+         search.
+
+         The category is given as std::random_access_iterator_tag, rather than
+         as a traversal tag, since from a traversal tag iterator_facade would
+         make a mutable iterator, whose reference is a proxy, only an input
+         iterator, and std::advance, std::distance, and rng.choice would then
+         walk it one site at a time.
+         */
+        template <typename Genome, typename Value, typename Reference>
+        class chunked_iterator : public boost::iterator_facade<chunked_iterator<Genome,Value,Reference>,
+        Value, std::random_access_iterator_tag, Reference> {
+        public:
+            chunked_iterator() : _g(0), _i(0), _c(0), _o(0) {
+            }
+
+            chunked_iterator(Genome* g, std::size_t i) : _g(g), _i(i) {
+                _g->locate(_i, _c, _o);
+            }
+
+            //! Conversion from a mutable to a const iterator.
+            template <typename G, typename V, typename R>
+            chunked_iterator(const chunked_iterator<G,V,R>& that) : _g(that._g), _i(that._i), _c(that._c), _o(that._o) {
+            }
+
+            std::size_t index() const {
+                return _i;
+            }
+
+            Genome* _g;
+            std::size_t _i; //!< Site index.
+            std::size_t _c; //!< Chunk.
+            std::size_t _o; //!< Offset within chunk.
+
+        private:
+            friend class boost::iterator_core_access;
+
+            Reference dereference() const {
+                return _g->site(_c, _o);
+            }
+
+            template <typename G, typename V, typename R>
+            bool equal(const chunked_iterator<G,V,R>& that) const {
+                return _i == that._i;
+            }
+
+            void increment() {
+                ++_i;
+                if(++_o == _g->_chunks[_c]->size()) {
+                    ++_c;
+                    _o = 0;
+                }
+            }
+
+            void decrement() {
+                --_i;
+                if(_o == 0) {
+                    --_c;
+                    _o = _g->_chunks[_c]->size();
+                }
+                --_o;
+            }
+
+            void advance(std::ptrdiff_t n) {
+                _i += n;
+                _g->locate(_i, _c, _o);
+            }
+
+            template <typename G, typename V, typename R>
+            std::ptrdiff_t distance_to(const chunked_iterator<G,V,R>& that) const {
+                return static_cast<std::ptrdiff_t>(that._i) - static_cast<std::ptrdiff_t>(_i);
+            }
+        };
+
+    } // detail
+
+
+    /*! A genome stored as a sequence of copy-on-write chunks.
+
+     Copying a chunked_genome copies only its table of chunks, which are then
+     shared between parent and offspring.  A chunk is cloned the first time one
+     of its sites is written, or when an insertion or deletion falls inside it,
+     so an asexual offspring that receives a few point mutations and an indel
+     costs a handful of chunk copies rather than a copy of the whole genome.
+
+     The interface is that of circular_genome (a std::vector), and so works
+     with the existing mutation operators and with mkv::build_markov_network,
+     with one difference: dereferencing a mutable iterator yields a proxy
+     rather than a T&.  Read-only code should use const iterators or
+     operator[] const, which never clone.  Chunks are drawn from the
+     per-thread buffer_pool.
+     */
+    template <typename T, std::size_t ChunkSize=1024>
+    class chunked_genome {
+    public:
+        typedef T value_type;
+        typedef std::size_t size_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef std::vector<T, pooled_allocator<T> > chunk_type;
+        typedef boost::shared_ptr<chunk_type> chunk_ptr;
+        typedef detail::chunked_site_reference<chunked_genome> reference;
+        typedef const T& const_reference;
+        typedef detail::chunked_iterator<chunked_genome, T, reference> iterator;
+        typedef detail::chunked_iterator<const chunked_genome, const T, const T&> const_iterator;
+
+        //! Constructor.
+        chunked_genome() : _size(0) {
+        }
+
+        //! Constructor.
+        chunked_genome(size_type n, const T& t=T()) : _size(0) {
+            resize(n, t);
+        }
+
+        //! Constructor.
+        template <typename InputIterator>
+        chunked_genome(InputIterator f, InputIterator l) : _size(0) {
+            chunk_type v(f, l);
+            assign_flat(v);
+        }
+
+        //! Returns the number of sites in this genome.
+        size_type size() const {
+            return _size;
+        }
+
+        //! Returns true if this genome has no sites.
+        bool empty() const {
+            return _size == 0;
+        }
+
+        //! Returns the number of sites this genome's chunks can hold (shared chunks included).
+        size_type capacity() const {
+            size_type n=0;
+            for(std::size_t c=0; c<_chunks.size(); ++c) {
+                n += _chunks[c]->capacity();
+            }
+            return n;
+        }
+
+        //! Returns the number of chunks in this genome.
+        std::size_t nchunks() const {
+            return _chunks.size();
+        }
+
+        //! Returns the number of chunks shared with other genomes.
+        std::size_t shared_chunks() const {
+            std::size_t n=0;
+            for(std::size_t c=0; c<_chunks.size(); ++c) {
+                n += !_chunks[c].unique();
+            }
+            return n;
+        }
+
+        iterator begin() {
+            return iterator(this, 0);
+        }
+
+        iterator end() {
+            return iterator(this, _size);
+        }
+
+        const_iterator begin() const {
+            return const_iterator(this, 0);
+        }
+
+        const_iterator end() const {
+            return const_iterator(this, _size);
+        }
+
+        const_reference operator[](size_type i) const {
+            std::size_t c, o;
+            locate(i, c, o);
+            return (*_chunks[c])[o];
+        }
+
+        reference operator[](size_type i) {
+            std::size_t c, o;
+            locate(i, c, o);
+            return reference(this, c, o);
+        }
+
+        //! Append x to the end of this genome.
+        void push_back(const T& x) {
+            if(_chunks.empty() || _chunks.back()->size() >= ChunkSize) {
+                _chunks.push_back(chunk_ptr(new chunk_type()));
+                _chunks.back()->reserve(ChunkSize);
+                _start.push_back(_size);
+            } else {
+                unshare(_chunks.size()-1);
+            }
+            _chunks.back()->push_back(x);
+            ++_size;
+        }
+
+        //! Resize this genome to n sites, filling any new sites with t.
+        void resize(size_type n, const T& t=T()) {
+            if(n < _size) {
+                erase(begin()+n, end());
+            } else {
+                while(_size < n) {
+                    push_back(t);
+                }
+            }
+        }
+
+        //! Remove all sites.
+        void clear() {
+            _chunks.clear();
+            _start.clear();
+            _size = 0;
+        }
+
+        /*! Insert [f,l) before pos.  The inserted sites are copied first, so
+         [f,l) may be a range of this genome.  Only the chunk that receives
+         them is cloned.
+         */
+        template <typename InputIterator>
+        void insert(iterator pos, InputIterator f, InputIterator l) {
+            chunk_type v(f, l);
+            if(v.empty()) {
+                return;
+            }
+            std::size_t i=pos.index();
+            if(_chunks.empty()) {
+                assign_flat(v);
+                return;
+            }
+
+            std::size_t c, o;
+            locate(i, c, o);
+            if(c == _chunks.size()) {
+                // appending; insert at the end of the last chunk:
+                --c;
+                o = _chunks[c]->size();
+            }
+            unshare(c);
+            _chunks[c]->insert(_chunks[c]->begin()+o, v.begin(), v.end());
+            _size += v.size();
+            split(c);
+            reindex();
+        }
+
+        //! Insert x before pos.
+        void insert(iterator pos, const T& x) {
+            insert(pos, &x, &x+1);
+        }
+
+        /*! Erase [f,l).  Chunks wholly within the range are dropped without
+         being copied; only the (at most two) chunks it partially covers are
+         cloned.
+         */
+        void erase(iterator f, iterator l) {
+            std::size_t a=f.index(), b=l.index();
+            if(a >= b) {
+                return;
+            }
+            std::vector<chunk_ptr> keep;
+            for(std::size_t c=0; c<_chunks.size(); ++c) {
+                std::size_t s=_start[c], e=s+_chunks[c]->size();
+                if(e <= a || s >= b) {
+                    keep.push_back(_chunks[c]);
+                } else if(a > s || b < e) {
+                    unshare(c);
+                    chunk_type& k=*_chunks[c];
+                    k.erase(k.begin() + (std::max(a,s) - s), k.begin() + (std::min(b,e) - s));
+                    keep.push_back(_chunks[c]);
+                }
+            }
+            _chunks.swap(keep);
+            _size -= b - a;
+            merge();
+            reindex();
+        }
+
+        //! Erase the site at pos.
+        void erase(iterator pos) {
+            erase(pos, pos+1);
+        }
+
+    protected:
+        template <typename G> friend class detail::chunked_site_reference;
+        template <typename G, typename V, typename R> friend class detail::chunked_iterator;
+
+        //! Replace the contents of this genome with the sites in v.
+        void assign_flat(const chunk_type& v) {
+            clear();
+            for(std::size_t i=0; i<v.size(); i+=ChunkSize) {
+                std::size_t e=std::min(v.size(), i+ChunkSize);
+                _chunks.push_back(chunk_ptr(new chunk_type(v.begin()+i, v.begin()+e)));
+                _start.push_back(i);
+            }
+            _size = v.size();
+        }
+
+        //! Set c and o to the chunk and offset of site i; site size() maps to (nchunks(), 0).
+        void locate(std::size_t i, std::size_t& c, std::size_t& o) const {
+            if(i >= _size) {
+                c = _chunks.size();
+                o = 0;
+                return;
+            }
+            c = (std::upper_bound(_start.begin(), _start.end(), i) - _start.begin()) - 1;
+            o = i - _start[c];
+        }
+
+        //! Returns a const reference to the site at chunk c, offset o.
+        const T& site(std::size_t c, std::size_t o) const {
+            return (*_chunks[c])[o];
+        }
+
+        //! Returns a proxy reference to the site at chunk c, offset o.
+        reference site(std::size_t c, std::size_t o) {
+            return reference(this, c, o);
+        }
+
+        //! Give this genome its own copy of chunk c, if it is shared.
+        void unshare(std::size_t c) {
+            if(!_chunks[c].unique()) {
+                chunk_ptr p(new chunk_type());
+                p->reserve(std::max(_chunks[c]->size(), ChunkSize));
+                p->assign(_chunks[c]->begin(), _chunks[c]->end());
+                _chunks[c] = p;
+            }
+        }
+
+        //! Split chunk c (which must be unshared) if it has grown past 2*ChunkSize.
+        void split(std::size_t c) {
+            chunk_type& k=*_chunks[c];
+            if(k.size() <= 2*ChunkSize) {
+                return;
+            }
+            std::vector<chunk_ptr> pieces;
+            for(std::size_t i=ChunkSize; i<k.size(); i+=ChunkSize) {
+                std::size_t e=std::min(k.size(), i+ChunkSize);
+                pieces.push_back(chunk_ptr(new chunk_type(k.begin()+i, k.begin()+e)));
+            }
+            k.resize(ChunkSize);
+            _chunks.insert(_chunks.begin()+c+1, pieces.begin(), pieces.end());
+        }
+
+        /*! Drop empty chunks, and fold chunks smaller than ChunkSize/4 into
+         their predecessor.  Chunks are moved (not copied) into the new table,
+         so that a predecessor is cloned only if another genome shares it.
+         */
+        void merge() {
+            std::vector<chunk_ptr> m;
+            m.reserve(_chunks.size());
+            for(std::size_t c=0; c<_chunks.size(); ++c) {
+                chunk_ptr& k=_chunks[c];
+                if(k->empty()) {
+                    continue;
+                }
+                if(!m.empty() && k->size() < ChunkSize/4 && m.back()->size() + k->size() <= 2*ChunkSize) {
+                    if(!m.back().unique()) {
+                        m.back() = chunk_ptr(new chunk_type(*m.back()));
+                    }
+                    m.back()->insert(m.back()->end(), k->begin(), k->end());
+                } else {
+                    m.push_back(chunk_ptr());
+                    m.back().swap(k);
+                }
+            }
+            _chunks.swap(m);
+        }
+
+        //! Recompute the index of the first site of each chunk.
+        void reindex() {
+            _start.resize(_chunks.size());
+            std::size_t s=0;
+            for(std::size_t c=0; c<_chunks.size(); ++c) {
+                _start[c] = s;
+                s += _chunks[c]->size();
+            }
+        }
+
+        std::vector<chunk_ptr> _chunks; //!< Chunks, in order.
+        std::vector<std::size_t> _start; //!< Index of the first site of each chunk.
+        std::size_t _size; //!< Number of sites.
+
+    private:
+        friend class boost::serialization::access;
+
+        //! Serialized as a flat sequence of sites, the same as circular_genome.
+        template<class Archive>
+        void save(Archive& ar, const unsigned int version) const {
+            std::vector<T> v(begin(), end());
+            ar & boost::serialization::make_nvp("circular_genome", v);
+        }
+
+        template<class Archive>
+        void load(Archive& ar, const unsigned int version) {
+            std::vector<T> v;
+            ar & boost::serialization::make_nvp("circular_genome", v);
+            assign_flat(chunk_type(v.begin(), v.end()));
+        }
+
+        BOOST_SERIALIZATION_SPLIT_MEMBER();
+    };
+
+} // ealib
+
+#endif
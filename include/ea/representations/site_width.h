@@ -0,0 +1,59 @@
+/* site_width.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_REPRESENTATIONS_SITE_WIDTH_H_
+#define _EA_REPRESENTATIONS_SITE_WIDTH_H_
+
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <boost/cstdint.hpp>
+#include <ea/meta_data.h>
+
+namespace ealib {
+
+    /* Genomes of integer sites need not store each site as a full int:
+     chunked_genome<T> takes the site type as a parameter, and Markov network
+     genomes, whose sites are drawn from [0, 32768], fit in a boost::uint16_t.  This halves genome memory and the
+     size of binary checkpoints, and doubles the number of sites per cache line
+     when a genome is decoded.
+     */
+
+    /*! Throws std::invalid_argument if the values that uniform integer mutation
+     can write (MUTATION_UNIFORM_INT_MIN to MUTATION_UNIFORM_INT_MAX) do not fit
+     in the site type of EA's representation.  Call this once, e.g., from the
+     fitness function's initialize().
+     */
+    template <typename EA>
+    void check_site_width(EA& ea) {
+        typedef typename EA::representation_type::value_type site_type;
+        long lo=get<MUTATION_UNIFORM_INT_MIN>(ea);
+        long hi=get<MUTATION_UNIFORM_INT_MAX>(ea);
+        if(lo < static_cast<long>(std::numeric_limits<site_type>::min())
+           || hi > static_cast<long>(std::numeric_limits<site_type>::max())) {
+            std::ostringstream msg;
+            msg << "mutation range [" << lo << ", " << hi << "] does not fit in a "
+            << (sizeof(site_type) * 8) << "-bit genome site";
+            throw std::invalid_argument(msg.str());
+        }
+    }
+
+} // ealib
+
+#endif
@@ -0,0 +1,90 @@
+/* ring_buffer.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_RING_BUFFER_H_
+#define _EA_RING_BUFFER_H_
+
+#include <cstddef>
+#include <vector>
+#include <stdexcept>
+#include <boost/atomic.hpp>
+
+namespace ealib {
+
+    /*! Bounded, lock-free, single-producer / single-consumer ring buffer.
+
+     Exactly one thread may call push(), and exactly one (possibly different)
+     thread may call pop().  Capacity is rounded up to a power of two.
+     */
+    template <typename T>
+    class spsc_ring_buffer {
+    public:
+        //! Constructor.
+        spsc_ring_buffer(std::size_t capacity) : _head(0), _tail(0) {
+            std::size_t n=1;
+            while(n < capacity) {
+                n <<= 1;
+            }
+            _mask = n - 1;
+            _slots.resize(n);
+        }
+
+        //! Push t into the buffer; returns false if the buffer is full.
+        bool push(const T& t) {
+            std::size_t tail=_tail.load(boost::memory_order_relaxed);
+            if((tail - _head.load(boost::memory_order_acquire)) > _mask) {
+                return false;
+            }
+            _slots[tail & _mask] = t;
+            _tail.store(tail+1, boost::memory_order_release);
+            return true;
+        }
+
+        //! Pop the oldest element into t; returns false if the buffer is empty.
+        bool pop(T& t) {
+            std::size_t head=_head.load(boost::memory_order_relaxed);
+            if(head == _tail.load(boost::memory_order_acquire)) {
+                return false;
+            }
+            t = _slots[head & _mask];
+            _head.store(head+1, boost::memory_order_release);
+            return true;
+        }
+
+        //! Returns true if the buffer is empty (approximate if called concurrently).
+        bool empty() const {
+            return _head.load(boost::memory_order_acquire) == _tail.load(boost::memory_order_acquire);
+        }
+
+        //! Returns the capacity of this buffer.
+        std::size_t capacity() const {
+            return _mask + 1;
+        }
+
+    protected:
+        std::size_t _mask; //!< Index mask (capacity-1).
+        std::vector<T> _slots; //!< Storage.
+        boost::atomic<std::size_t> _head; //!< Next slot to be read.
+        char _pad[64]; //!< Keep head and tail on separate cache lines.
+        boost::atomic<std::size_t> _tail; //!< Next slot to be written.
+    };
+
+} // ealib
+
+#endif
@@ -0,0 +1,49 @@
+/* batch_evaluated.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_SELECTION_BATCH_EVALUATED_H_
+#define _EA_SELECTION_BATCH_EVALUATED_H_
+
+#include <ea/batch_fitness.h>
+
+namespace ealib {
+    namespace selection {
+
+        /*! Evaluates all unevaluated individuals of the source population as a
+         single batch, if the EA's fitness function has a batch interface (see
+         ea/batch_fitness.h), before constructing the wrapped selection strategy.
+
+         Wrapping the replacement strategy of a steady-state model, for example,
+         scores each update's offspring in one pass instead of one at a time as
+         replacement first asks for their fitness.  With a fitness function
+         that has no batch interface, this wrapper does nothing.
+         */
+        template <typename Selection>
+        struct batch_evaluated : Selection {
+            //! Constructor.
+            template <typename Population, typename EA>
+            batch_evaluated(std::size_t n, Population& src, EA& ea)
+            : Selection((ealib::detail::evaluate_batch(src.begin(), src.end(), ea), n), src, ea) {
+            }
+        };
+
+    } // selection
+} // ealib
+
+#endif
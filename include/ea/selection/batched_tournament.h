@@ -0,0 +1,234 @@
+/* batched_tournament.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_SELECTION_BATCHED_TOURNAMENT_H_
+#define _EA_SELECTION_BATCHED_TOURNAMENT_H_
+
+#include <algorithm>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/weak_ptr.hpp>
+#include <boost/thread/tss.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <ea/access.h>
+#include <ea/fitness_function.h>
+#include <ea/meta_data.h>
+
+namespace ealib {
+    namespace selection {
+
+        namespace detail {
+
+            //! Compares indices into a fitness column, highest fitness first.
+            struct column_greater {
+                column_greater(const std::vector<double>& f) : _f(f) {
+                }
+
+                bool operator()(boost::int32_t a, boost::int32_t b) const {
+                    return _f[a] > _f[b];
+                }
+
+                const std::vector<double>& _f;
+            };
+
+            /*! For each of t tournaments of size n, write the index of the
+             fittest competitor to winners.  Competitors are stored member-major:
+             idx[j*t + k] is the j'th competitor in tournament k.  Ties go to
+             the earlier competitor.
+             */
+            inline void tournament_winners(const std::vector<double>& f,
+                                           const std::vector<boost::int32_t>& idx,
+                                           std::size_t n, std::size_t t,
+                                           std::vector<boost::int32_t>& winners) {
+                winners.assign(idx.begin(), idx.begin()+t);
+                std::vector<double> best(t);
+                for(std::size_t k=0; k<t; ++k) {
+                    best[k] = f[winners[k]];
+                }
+
+                for(std::size_t j=1; j<n; ++j) {
+                    const boost::int32_t* c=&idx[j*t];
+                    for(std::size_t k=0; k<t; ++k) {
+                        double x=f[c[k]];
+                        if(x > best[k]) {
+                            best[k] = x;
+                            winners[k] = c[k];
+                        }
+                    }
+                }
+            }
+
+            /*! The rows selected by the most recent batched_tournament on a
+             thread, and their fitnesses.  Rows are held by weak reference, so
+             that the column never keeps an individual (or its genome) alive,
+             yet a row can still be matched to a later population by identity:
+             while a row has not expired, its address cannot be reused.
+             */
+            template <typename Population>
+            struct fitness_column {
+                typedef typename Population::value_type individual_ptr_type;
+                typedef boost::weak_ptr<typename individual_ptr_type::element_type> row_type;
+
+                //! Returns true if row i is p.
+                bool matches(std::size_t i, const individual_ptr_type& p) const {
+                    return (i < rows.size()) && (addresses[i] == p.get()) && !rows[i].expired();
+                }
+
+                std::vector<row_type> rows; //!< Individuals selected, in order.
+                std::vector<const void*> addresses; //!< Address of each row.
+                std::vector<double> fitness; //!< Fitness of each row.
+            };
+
+            //! Returns the calling thread's fitness column for Population.
+            template <typename Population>
+            fitness_column<Population>& thread_fitness_column() {
+                // never destroyed, as for buffer_pool::local(); it holds no individuals:
+                static boost::thread_specific_ptr<fitness_column<Population> >* columns=new boost::thread_specific_ptr<fitness_column<Population> >();
+                fitness_column<Population>* c=columns->get();
+                if(c == 0) {
+                    c = new fitness_column<Population>();
+                    columns->reset(c);
+                }
+                return *c;
+            }
+
+            /*! True if an individual's fitness under FitnessFunction never
+             changes once it is known, so that it may be remembered across
+             updates: i.e., the fitness function is not stochastic (as are, for
+             example, those that race their trials).
+             */
+            template <typename FitnessFunction>
+            struct stable_fitness {
+                static const bool value=!boost::is_same<typename FitnessFunction::stochastic_tag, stochasticS>::value;
+            };
+
+        } // detail
+
+        /*! Tournament selection that runs every tournament needed for a call in
+         a single batch.
+
+         Fitnesses are gathered at construction into a contiguous column that
+         parallels the population.  When the EA's fitness function is not
+         stochastic, so that an individual's fitness never changes once it is
+         known, the column is kept across updates: the rows a tournament selects
+         are remembered (per thread, without holding the individuals), and when
+         the next population starts with those same individuals, as it does
+         when a generational model appends offspring to the survivors of the
+         previous replacement, only the rows that differ (the offspring) are
+         read from their individuals.  Stochastic fitness functions have every
+         row read.  All competitors are then drawn up front, and the winners
+         are found by sweeping over that column, so selection itself never
+         dereferences an individual.  As with selection::tournament, each tournament has
+         TOURNAMENT_SELECTION_N distinct competitors, of which the
+         TOURNAMENT_SELECTION_K fittest are selected.
+         */
+        template <typename AccessorType=access::fitness>
+        struct batched_tournament {
+            //! Constructor.
+            template <typename Population, typename EA>
+            batched_tournament(std::size_t n, Population& src, EA& ea) {
+                AccessorType acc;
+                const bool reuse=detail::stable_fitness<typename EA::fitness_function_type>::value;
+                detail::fitness_column<Population>& col=detail::thread_fitness_column<Population>();
+                _fitness.resize(src.size());
+                for(std::size_t i=0; i<src.size(); ++i) {
+                    if(reuse && col.matches(i, src[i])) {
+                        _fitness[i] = col.fitness[i];
+                    } else {
+                        _fitness[i] = static_cast<double>(acc(*src[i], ea));
+                    }
+                }
+            }
+
+            //! Select n individuals from src into dst.
+            template <typename Population, typename EA>
+            void operator()(Population& src, Population& dst, std::size_t n, EA& ea) {
+                std::size_t first=dst.size();
+                std::vector<double> selected;
+                std::size_t tn=std::min<std::size_t>(get<TOURNAMENT_SELECTION_N>(ea), src.size());
+                std::size_t tk=std::min<std::size_t>(get<TOURNAMENT_SELECTION_K>(ea), tn);
+                std::size_t t=(n + tk - 1) / tk; // number of tournaments
+
+                draw(tn, t, src.size(), ea);
+
+                if(tk == 1) {
+                    detail::tournament_winners(_fitness, _idx, tn, t, _winners);
+                    for(std::size_t k=0; k<n; ++k) {
+                        dst.insert(dst.end(), src[_winners[k]]);
+                        selected.push_back(_fitness[_winners[k]]);
+                    }
+                } else {
+                    std::vector<boost::int32_t> c(tn);
+                    for(std::size_t k=0; k<t && n>0; ++k) {
+                        for(std::size_t j=0; j<tn; ++j) {
+                            c[j] = _idx[j*t + k];
+                        }
+                        std::partial_sort(c.begin(), c.begin()+tk, c.end(), detail::column_greater(_fitness));
+                        for(std::size_t j=0; j<tk && n>0; ++j, --n) {
+                            dst.insert(dst.end(), src[c[j]]);
+                            selected.push_back(_fitness[c[j]]);
+                        }
+                    }
+                }
+
+                // remember the rows selected, for the next population:
+                detail::fitness_column<Population>& col=detail::thread_fitness_column<Population>();
+                col.rows.clear();
+                col.addresses.clear();
+                col.fitness.clear();
+                if(first == 0) {
+                    for(typename Population::iterator i=dst.begin(); i!=dst.end(); ++i) {
+                        col.rows.push_back(typename detail::fitness_column<Population>::row_type(*i));
+                        col.addresses.push_back(i->get());
+                    }
+                    col.fitness.swap(selected);
+                }
+            }
+
+            /*! Draw the competitors for t tournaments of size n from a population
+             of size m, distinct within each tournament, in member-major order.
+             */
+            template <typename EA>
+            void draw(std::size_t n, std::size_t t, std::size_t m, EA& ea) {
+                _idx.resize(n*t);
+                for(std::size_t k=0; k<t; ++k) {
+                    for(std::size_t j=0; j<n; ++j) {
+                        boost::int32_t x;
+                        bool dup;
+                        do {
+                            x = static_cast<boost::int32_t>(ea.rng().uniform_integer(0, m));
+                            dup = false;
+                            for(std::size_t l=0; l<j; ++l) {
+                                dup = dup || (_idx[l*t + k] == x);
+                            }
+                        } while(dup);
+                        _idx[j*t + k] = x;
+                    }
+                }
+            }
+
+            std::vector<double> _fitness; //!< Fitness column, parallel to the population.
+            std::vector<boost::int32_t> _idx; //!< Competitors, member-major.
+            std::vector<boost::int32_t> _winners; //!< Winner of each tournament.
+        };
+
+    } // selection
+} // ealib
+
+#endif
@@ -0,0 +1,229 @@
+/* fenwick_proportionate.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_SELECTION_FENWICK_PROPORTIONATE_H_
+#define _EA_SELECTION_FENWICK_PROPORTIONATE_H_
+
+#include <algorithm>
+#include <map>
+#include <vector>
+#include <boost/thread/tss.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/weak_ptr.hpp>
+#include <ea/access.h>
+#include <ea/fenwick_tree.h>
+#include <ea/selection/batched_tournament.h>
+
+namespace ealib {
+    namespace selection {
+
+        namespace detail {
+
+            /*! The weights of the population an EA last selected from, one slot
+             per individual, kept so that the next selection need only set the
+             weights of the individuals that have joined or left the
+             population.  As for fitness_column, individuals are held by weak
+             reference, so that they are never kept alive by the weights.
+             */
+            template <typename Population>
+            struct fenwick_rows {
+                typedef typename Population::value_type individual_ptr_type;
+                typedef boost::weak_ptr<typename individual_ptr_type::element_type> row_type;
+                typedef boost::unordered_map<const void*, std::size_t> slot_map_type;
+
+                //! Constructor.
+                fenwick_rows() : changes(0) {
+                }
+
+                fenwick_tree<double> tree; //!< Weight of each slot.
+                std::vector<row_type> rows; //!< Individual in each slot.
+                std::vector<const void*> addresses; //!< Address of each slot's individual (0 if free).
+                std::vector<std::size_t> free; //!< Free slots.
+                slot_map_type slots; //!< Slot of each individual, by address.
+                std::size_t changes; //!< Weights set since the tree was last refreshed.
+            };
+
+            /*! Returns the calling thread's weights for the EA at address ea,
+             when selecting with AccessorType.
+             */
+            template <typename AccessorType, typename Population>
+            fenwick_rows<Population>& thread_fenwick_rows(const void* ea) {
+                typedef std::map<const void*, fenwick_rows<Population> > map_type;
+                // never destroyed, as for thread_fitness_column; it holds no individuals:
+                static boost::thread_specific_ptr<map_type>* rows=new boost::thread_specific_ptr<map_type>();
+                map_type* m=rows->get();
+                if(m == 0) {
+                    m = new map_type();
+                    rows->reset(m);
+                }
+                return (*m)[ea];
+            }
+
+        } // detail
+
+        /*! Fitness-proportionate (roulette wheel) selection backed by a Fenwick
+         tree.
+
+         Each draw is O(log N), so selecting k individuals costs O(k log N)
+         after construction, rather than O(N k).  The tree is kept across
+         updates (per EA and thread, without holding the individuals): when
+         the EA's fitness function is not stochastic, construction matches the
+         population to the individuals in the tree, and only the weights of
+         individuals that have joined or left the population are set, each in
+         O(log N), so that survivors' fitnesses are not read again.  When most
+         of the population is new, or fitness is stochastic, the tree is
+         rebuilt in O(N) instead.  A selector must be used before another of
+         the same type is constructed for the same EA, as generational models
+         do.
+
+         Negative fitnesses are treated as zero; if every weight is zero,
+         individuals are selected uniformly at random.
+         */
+        template <typename AccessorType=access::fitness>
+        struct fenwick_proportionate {
+            //! Constructor.
+            template <typename Population, typename EA>
+            fenwick_proportionate(std::size_t n, Population& src, EA& ea) {
+                detail::fenwick_rows<Population>& r=detail::thread_fenwick_rows<AccessorType,Population>(&ea);
+                if(detail::stable_fitness<typename EA::fitness_function_type>::value) {
+                    update(r, src, ea);
+                } else {
+                    rebuild(r, src, ea);
+                }
+                _tree = &r.tree;
+            }
+
+            //! Select n individuals from src into dst, with replacement.
+            template <typename Population, typename EA>
+            void operator()(Population& src, Population& dst, std::size_t n, EA& ea) {
+                double total=_tree->total();
+                for( ; n>0; --n) {
+                    std::size_t i=_tree->size();
+                    if(total > 0.0) {
+                        i = _tree->find(ea.rng().uniform_real(0.0, total));
+                    }
+                    if(i < _index.size() && _index[i] < src.size()) {
+                        dst.insert(dst.end(), src[_index[i]]);
+                    } else {
+                        // no weight, or round-off landed on a free slot:
+                        dst.insert(dst.end(), src[ea.rng().uniform_integer(0, src.size())]);
+                    }
+                }
+            }
+
+            //! Returns the weight of individual ind.
+            template <typename Individual, typename EA>
+            static double weight(Individual& ind, EA& ea) {
+                AccessorType acc;
+                return std::max(0.0, static_cast<double>(acc(ind, ea)));
+            }
+
+            //! Rebuild r from src, in O(N).
+            template <typename Population, typename EA>
+            void rebuild(detail::fenwick_rows<Population>& r, Population& src, EA& ea) {
+                std::vector<double> w(src.size());
+                r.rows.resize(src.size());
+                r.addresses.resize(src.size());
+                r.free.clear();
+                r.slots.clear();
+                _index.resize(src.size());
+                for(std::size_t i=0; i<src.size(); ++i) {
+                    w[i] = weight(*src[i], ea);
+                    r.rows[i] = src[i];
+                    r.addresses[i] = src[i].get();
+                    r.slots.insert(std::make_pair(r.addresses[i], i));
+                    _index[i] = i;
+                }
+                r.tree.assign(w.begin(), w.end());
+                r.changes = 0;
+            }
+
+            /*! Match src to the slots of r, free the slots of individuals that
+             have left, and set the weights of those that have joined.
+             */
+            template <typename Population, typename EA>
+            void update(detail::fenwick_rows<Population>& r, Population& src, EA& ea) {
+                typedef typename detail::fenwick_rows<Population>::slot_map_type slot_map_type;
+                const std::size_t none=static_cast<std::size_t>(-1);
+                _index.assign(r.rows.size(), none);
+                std::vector<std::size_t> joined;
+                for(std::size_t i=0; i<src.size(); ++i) {
+                    typename slot_map_type::iterator s=r.slots.find(src[i].get());
+                    // a duplicate, or an expired row whose address was reused, is new:
+                    if((s != r.slots.end()) && (_index[s->second] == none) && !r.rows[s->second].expired()) {
+                        _index[s->second] = i;
+                    } else {
+                        joined.push_back(i);
+                    }
+                }
+                if(joined.size() > src.size()/2) {
+                    rebuild(r, src, ea);
+                    return;
+                }
+
+                for(std::size_t j=0; j<r.rows.size(); ++j) {
+                    if((_index[j] == none) && (r.addresses[j] != 0)) {
+                        typename slot_map_type::iterator s=r.slots.find(r.addresses[j]);
+                        if((s != r.slots.end()) && (s->second == j)) {
+                            r.slots.erase(s);
+                        }
+                        r.rows[j].reset();
+                        r.addresses[j] = 0;
+                        r.tree.set(j, 0.0);
+                        r.free.push_back(j);
+                        ++r.changes;
+                    }
+                }
+
+                for(std::vector<std::size_t>::iterator i=joined.begin(); i!=joined.end(); ++i) {
+                    double w=weight(*src[*i], ea);
+                    std::size_t j;
+                    if(r.free.empty()) {
+                        j = r.rows.size();
+                        r.rows.push_back(typename detail::fenwick_rows<Population>::row_type());
+                        r.addresses.push_back(0);
+                        r.tree.push_back(w);
+                        _index.push_back(none);
+                    } else {
+                        j = r.free.back();
+                        r.free.pop_back();
+                        r.tree.set(j, w);
+                    }
+                    r.rows[j] = src[*i];
+                    r.addresses[j] = src[*i].get();
+                    r.slots.insert(std::make_pair(r.addresses[j], j));
+                    _index[j] = *i;
+                    ++r.changes;
+                }
+
+                // set() accumulates round-off; start afresh once every slot could have changed:
+                if(r.changes > r.rows.size()) {
+                    r.tree.refresh();
+                    r.changes = 0;
+                }
+            }
+
+            fenwick_tree<double>* _tree; //!< Fitness weights, one per slot.
+            std::vector<std::size_t> _index; //!< Index in the population of each slot's individual.
+        };
+
+    } // selection
+} // ealib
+
+#endif
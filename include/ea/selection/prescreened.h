@@ -0,0 +1,253 @@
+/* prescreened.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_SELECTION_PRESCREENED_H_
+#define _EA_SELECTION_PRESCREENED_H_
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/serialization/nvp.hpp>
+#include <ea/meta_data.h>
+#include <ea/batch_fitness.h>
+#include <ea/surrogate.h>
+
+namespace ealib {
+
+    LIBEA_MD_DECL(PRESCREEN_FRACTION, "ea.prescreen.fraction", double);
+    LIBEA_MD_DECL(PRESCREEN_WARMUP, "ea.prescreen.warmup", unsigned int);
+    LIBEA_MD_DECL(PRESCREEN_AUDIT_P, "ea.prescreen.audit.p", double);
+    LIBEA_MD_DECL(PRESCREEN_KMER, "ea.prescreen.kmer", unsigned int);
+    LIBEA_MD_DECL(PRESCREEN_FEATURES, "ea.prescreen.features", unsigned int);
+    LIBEA_MD_DECL(PRESCREEN_LEARNING_RATE, "ea.prescreen.learning_rate", double);
+
+    //! Counts of offspring pre-screened by all surrogates in the process.
+    struct prescreen_stats {
+        prescreen_stats() : screened(0), accepted(0), rejected(0), audited(0), false_rejections(0), errors(0), abs_error(0.0) {
+        }
+
+        boost::uint64_t screened; //!< Offspring seen by the surrogate.
+        boost::uint64_t accepted; //!< Offspring sent to the fitness function on the surrogate's say-so.
+        boost::uint64_t rejected; //!< Offspring not evaluated.
+        boost::uint64_t audited; //!< Rejected offspring evaluated anyway, to check the surrogate.
+        boost::uint64_t false_rejections; //!< Audited offspring that beat the mean of those accepted alongside them.
+        boost::uint64_t errors; //!< Predictions compared to real fitness.
+        double abs_error; //!< Sum of absolute prediction errors.
+    };
+
+    //! Returns the process-wide pre-screening statistics.
+    inline prescreen_stats& global_prescreen_stats() {
+        static prescreen_stats s;
+        return s;
+    }
+
+    /*! Adds the surrogate model used by selection::prescreened to a fitness
+     function, so that each EA has a model of its own, which is serialized
+     along with the fitness function.  The fitness function itself is
+     unchanged.
+     */
+    template <typename FitnessFunction>
+    struct prescreened_fitness : FitnessFunction {
+        prescreened_fitness() : _initialized(false) {
+        }
+
+        //! Returns the surrogate, creating it on first use from ea's meta-data.
+        template <typename EA>
+        kmer_surrogate& surrogate(EA& ea) {
+            if(!_initialized) {
+                _surrogate = kmer_surrogate(get<PRESCREEN_KMER>(ea, 2),
+                                            get<PRESCREEN_FEATURES>(ea, 4096),
+                                            get<PRESCREEN_LEARNING_RATE>(ea, 0.05));
+                _initialized = true;
+            }
+            return _surrogate;
+        }
+
+        template <class Archive>
+        void serialize(Archive& ar, const unsigned int version) {
+            ar & boost::serialization::make_nvp("initialized", _initialized);
+            ar & boost::serialization::make_nvp("surrogate", _surrogate);
+        }
+
+        bool _initialized; //!< Whether the surrogate has been created.
+        kmer_surrogate _surrogate; //!< Model of fitness.
+    };
+
+    //! A pre-screened fitness function has a batch interface only if the one it wraps does.
+    template <typename FitnessFunction>
+    struct has_batch_evaluation<prescreened_fitness<FitnessFunction> > : has_batch_evaluation<FitnessFunction> {
+    };
+
+    namespace detail {
+
+        //! Used to order offspring by predicted fitness, best first.
+        struct prediction_order {
+            prediction_order(const std::vector<double>& p) : _p(p) {
+            }
+
+            bool operator()(std::size_t a, std::size_t b) const {
+                return _p[a] > _p[b];
+            }
+
+            const std::vector<double>& _p;
+        };
+
+        /*! Screen the unevaluated individuals of population: the best
+         PRESCREEN_FRACTION of them, by predicted fitness, are evaluated (as a
+         batch, if the fitness function has a batch interface), and the rest
+         are removed from population unevaluated.  The surrogate then learns
+         the real fitness of those that were evaluated.
+         */
+        template <typename Population, typename EA>
+        void prescreen(Population& population, EA& ea) {
+            typedef typename Population::value_type individual_ptr_type;
+            double fraction=get<PRESCREEN_FRACTION>(ea, 0.0);
+            if(fraction <= 0.0 || fraction >= 1.0) {
+                return;
+            }
+            kmer_surrogate& model=ea.fitness_function().surrogate(ea);
+
+            std::vector<std::size_t> offspring;
+            for(std::size_t i=0; i<population.size(); ++i) {
+                if(population[i]->fitness().is_null()) {
+                    offspring.push_back(i);
+                }
+            }
+            if(offspring.empty()) {
+                return;
+            }
+
+            prescreen_stats& st=global_prescreen_stats();
+            std::vector<kmer_surrogate::features_type> x(offspring.size());
+            std::vector<double> p(offspring.size());
+            for(std::size_t i=0; i<offspring.size(); ++i) {
+                const typename EA::representation_type& repr=population[offspring[i]]->repr();
+                model.features(repr.begin(), repr.end(), x[i]);
+                p[i] = model.predict(x[i]);
+            }
+            st.screened += offspring.size();
+
+            // until the surrogate has learned from enough real evaluations,
+            // everything is accepted:
+            std::vector<char> audit(offspring.size(), 0), reject(offspring.size(), 0);
+            if(model.observations() < std::max(1u, get<PRESCREEN_WARMUP>(ea, 256))) {
+                st.accepted += offspring.size();
+            } else {
+                std::vector<std::size_t> order(offspring.size());
+                for(std::size_t i=0; i<order.size(); ++i) {
+                    order[i] = i;
+                }
+                std::sort(order.begin(), order.end(), prediction_order(p));
+                std::size_t m=std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(fraction * offspring.size())));
+                st.accepted += m;
+
+                double audit_p=get<PRESCREEN_AUDIT_P>(ea, 0.1);
+                for(std::size_t i=m; i<order.size(); ++i) {
+                    if(ea.rng().p(audit_p)) {
+                        audit[order[i]] = 1;
+                        ++st.audited;
+                    } else {
+                        reject[order[i]] = 1;
+                        ++st.rejected;
+                    }
+                }
+            }
+
+            // remove the rejected, keeping the rest in order:
+            std::vector<individual_ptr_type> kept;
+            std::vector<individual_ptr_type> evaluated;
+            std::vector<std::size_t> evaluated_at;
+            for(std::size_t i=0, j=0; i<population.size(); ++i) {
+                if(j < offspring.size() && offspring[j] == i) {
+                    if(!reject[j]) {
+                        evaluated.push_back(population[i]);
+                        evaluated_at.push_back(j);
+                        kept.push_back(population[i]);
+                    }
+                    ++j;
+                } else {
+                    kept.push_back(population[i]);
+                }
+            }
+            if(kept.size() < population.size()) {
+                population.clear();
+                population.insert(population.end(), kept.begin(), kept.end());
+            }
+
+            // evaluate the rest, and learn from them:
+            ealib::detail::evaluate_batch(evaluated.begin(), evaluated.end(), ea);
+            double sum=0.0;
+            std::size_t n=0;
+            std::vector<double> y(evaluated.size());
+            for(std::size_t i=0; i<evaluated.size(); ++i) {
+                std::size_t j=evaluated_at[i];
+                y[i] = static_cast<double>(ealib::fitness(*evaluated[i], ea));
+                model.learn(x[j], y[i]);
+                st.abs_error += std::fabs(y[i] - p[j]);
+                ++st.errors;
+                if(!audit[j]) {
+                    sum += y[i];
+                    ++n;
+                }
+            }
+            for(std::size_t i=0; i<evaluated.size(); ++i) {
+                if(audit[evaluated_at[i]] && n > 0 && y[i] > (sum / n)) {
+                    ++st.false_rejections;
+                }
+            }
+        }
+
+    } // detail
+
+    namespace selection {
+
+        /*! Screens unevaluated individuals of the source population with a
+         surrogate model of fitness before constructing the wrapped selection
+         strategy, so that only the most promising of them are evaluated.
+
+         The surrogate (a kmer_surrogate) belongs to the EA's fitness function,
+         which must be wrapped in prescreened_fitness, and is trained online on
+         the real fitness of the offspring it lets through.  Once it has learned
+         from PRESCREEN_WARMUP evaluations (default 256), only the best
+         PRESCREEN_FRACTION of each screening's offspring, by predicted fitness,
+         are evaluated; the rest are removed from the source population without
+         being evaluated, and so neither survive nor reproduce.  A fraction of
+         0 (the default) or of 1 turns screening off.  Each rejected offspring
+         is, with probability PRESCREEN_AUDIT_P (default 0.1), evaluated and
+         kept anyway, so that datafiles::prescreening can report how often the
+         surrogate rejects offspring better than those it accepts.
+
+         Wrap the survivor selection strategy, which is the first to see each
+         update's offspring; since the offspring are evaluated here, as a batch
+         where possible, no batch_evaluated wrapper is needed inside.
+         */
+        template <typename Selection>
+        struct prescreened : Selection {
+            //! Constructor.
+            template <typename Population, typename EA>
+            prescreened(std::size_t n, Population& src, EA& ea)
+            : Selection((ealib::detail::prescreen(src, ea), n), src, ea) {
+            }
+        };
+
+    } // selection
+} // ealib
+
+#endif
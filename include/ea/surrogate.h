@@ -0,0 +1,133 @@
+/* surrogate.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_SURROGATE_H_
+#define _EA_SURROGATE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <utility>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/serialization/nvp.hpp>
+#include <boost/serialization/vector.hpp>
+#include <ea/fitness_functions/memoized.h>
+
+namespace ealib {
+
+    /*! An online linear model of fitness over the k-mers of a genome.
+
+     Each run of k consecutive sites is hashed into one of d buckets, and a
+     genome's features are its bucket counts, divided by the square root of
+     its number of k-mers so that long and short genomes are on the same
+     scale.  Fitness is predicted as a bias plus the dot product of the
+     features with a weight vector, which is trained one observation at a time
+     by normalized least mean squares.  Features are sparse, so predicting and
+     learning are linear in the length of the genome, not in d.
+     */
+    class kmer_surrogate {
+    public:
+        //! Sparse features: (bucket, value) pairs.
+        typedef std::vector<std::pair<boost::uint32_t, double> > features_type;
+
+        //! Constructor.
+        kmer_surrogate(std::size_t k=2, std::size_t d=4096, double rate=0.05)
+        : _k(std::max<std::size_t>(1, k)), _w(std::max<std::size_t>(1, d), 0.0), _b(0.0), _rate(rate), _n(0) {
+        }
+
+        //! Set x to the features of the genome [f,l).
+        template <typename ForwardIterator>
+        void features(ForwardIterator f, ForwardIterator l, features_type& x) const {
+            x.clear();
+            std::deque<boost::uint64_t> window;
+            std::vector<boost::uint32_t> buckets;
+            for( ; f!=l; ++f) {
+                window.push_back(static_cast<boost::uint64_t>(*f));
+                if(window.size() > _k) {
+                    window.pop_front();
+                }
+                if(window.size() == _k) {
+                    buckets.push_back(static_cast<boost::uint32_t>(hash_genome(window.begin(), window.end()).h1 % _w.size()));
+                }
+            }
+            if(buckets.empty()) {
+                return;
+            }
+            std::sort(buckets.begin(), buckets.end());
+            double scale=1.0 / std::sqrt(static_cast<double>(buckets.size()));
+            for(std::size_t i=0; i<buckets.size(); ) {
+                std::size_t j=i;
+                while(j < buckets.size() && buckets[j] == buckets[i]) {
+                    ++j;
+                }
+                x.push_back(std::make_pair(buckets[i], scale * (j - i)));
+                i = j;
+            }
+        }
+
+        //! Returns the predicted fitness of a genome with features x.
+        double predict(const features_type& x) const {
+            double y=_b;
+            for(features_type::const_iterator i=x.begin(); i!=x.end(); ++i) {
+                y += _w[i->first] * i->second;
+            }
+            return y;
+        }
+
+        //! Learn that a genome with features x has fitness y.
+        void learn(const features_type& x, double y) {
+            double norm=1.0;
+            for(features_type::const_iterator i=x.begin(); i!=x.end(); ++i) {
+                norm += i->second * i->second;
+            }
+            double g=_rate * (y - predict(x)) / norm;
+            _b += g;
+            for(features_type::const_iterator i=x.begin(); i!=x.end(); ++i) {
+                _w[i->first] += g * i->second;
+            }
+            ++_n;
+        }
+
+        //! Returns the number of observations learned from.
+        std::size_t observations() const {
+            return _n;
+        }
+
+        //! Serialize this model.
+        template <class Archive>
+        void serialize(Archive& ar, const unsigned int version) {
+            ar & boost::serialization::make_nvp("k", _k);
+            ar & boost::serialization::make_nvp("weights", _w);
+            ar & boost::serialization::make_nvp("bias", _b);
+            ar & boost::serialization::make_nvp("rate", _rate);
+            ar & boost::serialization::make_nvp("observations", _n);
+        }
+
+    protected:
+        std::size_t _k; //!< Sites per k-mer.
+        std::vector<double> _w; //!< Weight of each bucket.
+        double _b; //!< Bias.
+        double _rate; //!< Learning rate.
+        std::size_t _n; //!< Observations so far.
+    };
+
+} // ealib
+
+#endif
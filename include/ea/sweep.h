@@ -0,0 +1,269 @@
+/* sweep.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _EA_SWEEP_H_
+#define _EA_SWEEP_H_
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <boost/lexical_cast.hpp>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <ea/cmdline_interface.h>
+
+/* Replicate and parameter-sweep mode for the command-line interface.
+
+ An EA whose interface is declared with LIBEA_SWEEP_INSTANCE instead of
+ LIBEA_CMDLINE_INSTANCE runs exactly as before, unless it is given a sweep
+ file:
+
+     ./all_ones -c etc/all_ones.cfg --sweep grid.txt [--sweep-jobs n]
+
+ A sweep file lists one option per line, with the values it should take:
+
+     # 30 replicates of each of 3 mutation rates:
+     ea.rng.seed = 1..30
+     ea.mutation.site.p = 0.001 0.01 0.1
+
+ Every combination of values is a run, which is given the remaining
+ command-line arguments plus one --option=value override per line.  Runs are
+ started from a single process, up to n at a time (by default, one per
+ processor), each as soon as a previous one finishes.  Each run is a fork of
+ the already-initialized process, and so pays no exec, dynamic loading, or
+ static initialization cost of its own.  It writes its datafiles to
+ sweep/<i>/, and sweep/runs.txt maps each i to its overrides.
+
+ Runs are separate processes, rather than threads, because an EA's datafiles
+ (and checkpoints) are opened by relative path, and only a process has a
+ working directory of its own.
+ */
+
+namespace ealib {
+
+    //! One dimension of a sweep: an option and the values it takes.
+    struct sweep_dimension {
+        std::string key;
+        std::vector<std::string> values;
+    };
+
+    /*! Read the dimensions of a sweep from filename.  Values are separated by
+     whitespace, and a value of the form a..b expands to the integers a to b.
+     */
+    inline std::vector<sweep_dimension> read_sweep(const std::string& filename) {
+        std::ifstream in(filename.c_str());
+        if(!in.good()) {
+            throw std::runtime_error("could not open sweep file " + filename);
+        }
+        std::vector<sweep_dimension> dims;
+        std::string line;
+        while(std::getline(in, line)) {
+            std::size_t eq=line.find('=');
+            if(line.empty() || line[0] == '#' || eq == std::string::npos) {
+                continue;
+            }
+            sweep_dimension d;
+            std::istringstream ks(line.substr(0, eq));
+            ks >> d.key;
+            std::istringstream vs(line.substr(eq+1));
+            std::string v;
+            while(vs >> v) {
+                std::size_t dots=v.find("..");
+                if(dots != std::string::npos) {
+                    long a=boost::lexical_cast<long>(v.substr(0, dots));
+                    long b=boost::lexical_cast<long>(v.substr(dots+2));
+                    for(long x=a; x<=b; ++x) {
+                        d.values.push_back(boost::lexical_cast<std::string>(x));
+                    }
+                } else {
+                    d.values.push_back(v);
+                }
+            }
+            if(d.key.empty() || d.values.empty()) {
+                throw std::runtime_error("malformed sweep line: " + line);
+            }
+            dims.push_back(d);
+        }
+        return dims;
+    }
+
+    //! Returns the option overrides of every run in the sweep over dims.
+    inline std::vector<std::vector<std::string> > sweep_runs(const std::vector<sweep_dimension>& dims) {
+        std::vector<std::vector<std::string> > runs(1);
+        for(std::size_t i=0; i<dims.size(); ++i) {
+            std::vector<std::vector<std::string> > next;
+            for(std::size_t j=0; j<runs.size(); ++j) {
+                for(std::size_t k=0; k<dims[i].values.size(); ++k) {
+                    next.push_back(runs[j]);
+                    next.back().push_back("--" + dims[i].key + "=" + dims[i].values[k]);
+                }
+            }
+            runs.swap(next);
+        }
+        return runs;
+    }
+
+    /*! Adds sweep mode to the command-line interface CLI; see LIBEA_SWEEP_INSTANCE.
+     */
+    template <typename EA, typename CLI>
+    class sweep_interface : public CLI {
+    public:
+        virtual ~sweep_interface() {
+        }
+
+        //! Run the EA, or a sweep over it if --sweep was given.
+        virtual void exec(int argc, char* argv[]) {
+            std::vector<std::string> args;
+            std::string sweep_file;
+            long jobs=sysconf(_SC_NPROCESSORS_ONLN);
+            for(int i=0; i<argc; ++i) {
+                std::string a=argv[i];
+                if(a == "--sweep" && (i+1) < argc) {
+                    sweep_file = argv[++i];
+                } else if(a == "--sweep-jobs" && (i+1) < argc) {
+                    jobs = std::atol(argv[++i]);
+                } else if(i > 0 && (a == "-c" || a == "--config" || a == "-l" || a == "--load") && (i+1) < argc) {
+                    // runs change directory, so files named on the command line must be absolute:
+                    args.push_back(a);
+                    args.push_back(absolute(argv[++i]));
+                } else {
+                    args.push_back(a);
+                }
+            }
+
+            if(sweep_file.empty()) {
+                CLI::exec(argc, argv);
+            } else {
+                sweep(args, read_sweep(sweep_file), std::max(1L, jobs));
+            }
+        }
+
+    protected:
+        //! Returns an absolute version of path.
+        static std::string absolute(const std::string& path) {
+            if(!path.empty() && path[0] == '/') {
+                return path;
+            }
+            char buf[4096];
+            if(getcwd(buf, sizeof(buf)) == 0) {
+                throw std::runtime_error("could not determine working directory");
+            }
+            return std::string(buf) + "/" + path;
+        }
+
+        //! Run every combination of dims, up to jobs at a time.
+        void sweep(const std::vector<std::string>& args, const std::vector<sweep_dimension>& dims, long jobs) {
+            std::vector<std::vector<std::string> > runs=sweep_runs(dims);
+            mkdir("sweep", 0755);
+            std::ofstream index("sweep/runs.txt");
+            for(std::size_t i=0; i<runs.size(); ++i) {
+                index << i;
+                for(std::size_t j=0; j<runs[i].size(); ++j) {
+                    index << " " << runs[i][j];
+                }
+                index << std::endl;
+            }
+            index.close();
+            std::cout.flush();
+            std::cerr.flush();
+
+            std::size_t next=0, failed=0;
+            long running=0;
+            while(next < runs.size() || running > 0) {
+                if(next < runs.size() && running < jobs) {
+                    pid_t pid=fork();
+                    if(pid == 0) {
+                        // exit, not _exit: the run's events belong to the static
+                        // interface, and only its destructors drain asynchronous
+                        // datafiles, flush streams, and unlink shared memory.
+                        std::exit(run(next, args, runs[next]));
+                    } else if(pid < 0) {
+                        throw std::runtime_error(std::string("fork failed: ") + std::strerror(errno));
+                    }
+                    ++next;
+                    ++running;
+                } else {
+                    int status=0;
+                    if(wait(&status) < 0) {
+                        throw std::runtime_error(std::string("wait failed: ") + std::strerror(errno));
+                    }
+                    --running;
+                    if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                        ++failed;
+                    }
+                }
+            }
+
+            std::cerr << runs.size() << " run(s) complete";
+            if(failed > 0) {
+                std::cerr << ", " << failed << " failed (see sweep/*/output.txt)";
+            }
+            std::cerr << std::endl;
+            if(failed > 0) {
+                throw std::runtime_error("sweep failed");
+            }
+        }
+
+        //! Run i of a sweep, in a forked child; returns its exit status.
+        int run(std::size_t i, std::vector<std::string> args, const std::vector<std::string>& overrides) {
+            std::string dir="sweep/" + boost::lexical_cast<std::string>(i);
+            mkdir(dir.c_str(), 0755);
+            if(chdir(dir.c_str()) != 0
+               || freopen("output.txt", "w", stdout) == 0
+               || freopen("output.txt", "a", stderr) == 0) {
+                return 127;
+            }
+            args.insert(args.end(), overrides.begin(), overrides.end());
+            std::vector<char*> argv;
+            for(std::size_t j=0; j<args.size(); ++j) {
+                argv.push_back(const_cast<char*>(args[j].c_str()));
+            }
+            argv.push_back(0);
+
+            try {
+                CLI::exec(static_cast<int>(args.size()), &argv[0]);
+            } catch(std::exception& e) {
+                std::cerr << "error: " << e.what() << std::endl;
+                return 1;
+            }
+            std::cout.flush();
+            std::cerr.flush();
+            return 0;
+        }
+    };
+
+} // ealib
+
+/*! Declares the command-line interface of an EA, with sweep mode; use in place
+ of LIBEA_CMDLINE_INSTANCE.
+ */
+#define LIBEA_SWEEP_INSTANCE( ea_type, cmdline_type ) \
+template <typename EA> class cmdline_type##_sweep : public ealib::sweep_interface<EA, cmdline_type<EA> > { }; \
+LIBEA_CMDLINE_INSTANCE(ea_type, cmdline_type##_sweep)
+
+#endif
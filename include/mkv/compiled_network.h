@@ -0,0 +1,648 @@
+/* compiled_network.h
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _MKV_COMPILED_NETWORK_H_
+#define _MKV_COMPILED_NETWORK_H_
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <ea/counter_rng.h>
+#include <ea/markov_network.h>
+
+namespace mkv {
+
+    /*! A Markov network flattened for fast, repeated updates.
+
+     A network decoded by build_markov_network is a list of separately allocated
+     gates, and each probabilistic gate samples its output by walking a row of
+     floating-point probabilities.  Here, all gates live in one array, their
+     wiring in another, and their tables in a third:
+
+     - a logic gate's table holds the output pattern of each input pattern;
+     - a probabilistic gate's table holds, for each input pattern, the
+       cumulative probabilities of its first 2^nout-1 output patterns, scaled to
+       32-bit integer thresholds, so that sampling is a random word and a few
+       integer comparisons.
+
+     Random words for probabilistic gates are drawn from a counter_rng in bulk,
+     a pool at a time, shared by all gates and all updates (and so all trials)
+     until it runs out.
+
+     States are numbered inputs first, then outputs, then hidden states, and the
+     kth input (output) of a gate is bit k of its input (output) pattern.
+     Networks with adaptive gates, whose tables change as they run, are not
+     compiled; see compile().  Once compiled, optimize() removes the gates and
+     states that can't affect the outputs.
+     */
+    class compiled_network {
+    public:
+        typedef boost::uint8_t state_type;
+        typedef boost::uint32_t word_type;
+        typedef std::vector<state_type>::iterator iterator;
+
+        //! Kinds of compiled gate.
+        enum gate_kind { LOGIC, PROBABILISTIC };
+
+        //! A compiled gate.
+        struct gate {
+            gate_kind kind;
+            word_type in; //!< Offset of the gate's inputs in the wiring.
+            word_type nin; //!< Number of inputs.
+            word_type out; //!< Offset of the gate's outputs in the wiring.
+            word_type nout; //!< Number of outputs.
+            word_type table; //!< Offset of the gate's table.
+        };
+
+        //! Constructor.
+        compiled_network(unsigned int seed, std::size_t pool=1024)
+        : _nin(0), _nout(0), _nprob(0), _rng(seed), _pool(pool), _next(pool) {
+        }
+
+        /*! Compile net into this network, replacing its contents; returns false,
+         leaving this network empty, if net contains a gate that can't be
+         compiled.
+         */
+        bool compile(markov_network& net) {
+            _gates.clear();
+            _wiring.clear();
+            _tables.clear();
+            _nin = net.ninput_states();
+            _nout = net.noutput_states();
+            _nprob = 0;
+            _sv.assign(_nin + _nout + net.nhidden_states(), 0);
+            _svm1.assign(_sv.size(), 0);
+
+            // the only place that knows how libmkv represents gates:
+            for(markov_network::iterator i=net.begin(); i!=net.end(); ++i) {
+                if(dynamic_cast<adaptive_gate*>(i->get()) != 0) {
+                    _gates.clear();
+                    return false;
+                } else if(logic_gate* g=dynamic_cast<logic_gate*>(i->get())) {
+                    add_gate(LOGIC, g->inputs, g->outputs);
+                    for(std::size_t j=0; j<g->M.size(); ++j) {
+                        _tables.push_back(static_cast<word_type>(g->M[j]));
+                    }
+                } else if(probabilistic_gate* g=dynamic_cast<probabilistic_gate*>(i->get())) {
+                    add_gate(PROBABILISTIC, g->inputs, g->outputs);
+                    for(std::size_t j=0; j<g->M.size1(); ++j) {
+                        std::vector<double> row(g->M.size2());
+                        for(std::size_t k=0; k<row.size(); ++k) {
+                            row[k] = g->M(j,k);
+                        }
+                        add_thresholds(row);
+                    }
+                    ++_nprob;
+                } else {
+                    _gates.clear();
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        //! Returns the number of input states.
+        std::size_t ninput_states() const {
+            return _nin;
+        }
+
+        //! Returns the number of output states.
+        std::size_t noutput_states() const {
+            return _nout;
+        }
+
+        //! Returns the number of compiled gates.
+        std::size_t ngates() const {
+            return _gates.size();
+        }
+
+        //! Returns the number of probabilistic gates.
+        std::size_t nprobabilistic() const {
+            return _nprob;
+        }
+
+        //! Returns the number of states.
+        std::size_t nstates() const {
+            return _sv.size();
+        }
+
+        /*! Optimize this network without changing what it computes.
+
+         This is the dependency analysis of the reduced_graph tool, applied to
+         the compiled network:
+
+         - a state is live if it is an output, or if a live gate reads it, and a
+           gate is live if it writes a live state, so only live gates and live
+           states are kept;
+         - writes to dead states and to inputs (which are overwritten before they
+           are read) are dropped, and reads of states that no gate writes (which
+           are always zero) are folded into the gate's table;
+         - logic gates that write the same set of states are merged into one,
+           as long as the merged gate has at most max_merged_inputs inputs;
+         - gates are ordered by their distance from the inputs, and hidden states
+           are renumbered in the order gates write them, so that each update
+           sweeps forward through the state vectors.
+
+         Since every gate reads states at t-1 and writes states at t, the order
+         of gates doesn't matter to the result.  Probabilistic gates that are
+         removed or reordered draw different random words, so results are
+         equal in distribution, but not identical, to those of the unoptimized
+         network.
+         */
+        void optimize(std::size_t max_merged_inputs=8) {
+            std::vector<expanded_gate> gates;
+            std::vector<char> live(_sv.size(), 0), written(_sv.size(), 0);
+            mark_live(live);
+
+            for(std::size_t i=0; i<_gates.size(); ++i) {
+                const gate& g=_gates[i];
+                bool writes_live=false;
+                for(word_type j=0; j<g.nout; ++j) {
+                    word_type s=_wiring[g.out+j];
+                    writes_live = writes_live || (s >= _nin && live[s]);
+                }
+                if(writes_live) {
+                    gates.push_back(expand(g));
+                }
+            }
+
+            // drop dead writes, then note what's written:
+            for(std::size_t i=0; i<gates.size(); ++i) {
+                expanded_gate& g=gates[i];
+                for(std::size_t j=g.out.size(); j>0; --j) {
+                    if(g.out[j-1] < _nin || !live[g.out[j-1]]) {
+                        drop_output(g, j-1);
+                    }
+                }
+                for(std::size_t j=0; j<g.out.size(); ++j) {
+                    written[g.out[j]] = 1;
+                }
+            }
+
+            // fold constant inputs:
+            for(std::size_t i=0; i<gates.size(); ++i) {
+                expanded_gate& g=gates[i];
+                for(std::size_t j=g.in.size(); j>0; --j) {
+                    if(g.in[j-1] >= _nin && !written[g.in[j-1]]) {
+                        drop_input(g, j-1);
+                    }
+                }
+            }
+
+            // merge logic gates with the same outputs; gates are grouped by their
+            // set of outputs, so that only gates that could merge are compared:
+            std::vector<std::pair<std::vector<word_type>, std::size_t> > keys;
+            for(std::size_t i=0; i<gates.size(); ++i) {
+                if(gates[i].kind == LOGIC) {
+                    keys.push_back(std::make_pair(gates[i].out, i));
+                    std::vector<word_type>& k=keys.back().first;
+                    std::sort(k.begin(), k.end());
+                    k.erase(std::unique(k.begin(), k.end()), k.end());
+                }
+            }
+            std::sort(keys.begin(), keys.end());
+            std::vector<char> merged(gates.size(), 0);
+            for(std::size_t i=0; i<keys.size(); ) {
+                std::size_t e=i+1;
+                while((e < keys.size()) && (keys[e].first == keys[i].first)) {
+                    ++e;
+                }
+                for(std::size_t j=i; j<e; ++j) {
+                    for(std::size_t k=j+1; (k < e) && !merged[keys[j].second]; ++k) {
+                        if(!merged[keys[k].second] && merge(gates[keys[j].second], gates[keys[k].second], max_merged_inputs)) {
+                            merged[keys[k].second] = 1;
+                        }
+                    }
+                }
+                i = e;
+            }
+            std::size_t n=0;
+            for(std::size_t i=0; i<gates.size(); ++i) {
+                if(!merged[i]) {
+                    if(n != i) {
+                        std::swap(gates[n], gates[i]);
+                    }
+                    ++n;
+                }
+            }
+            gates.resize(n);
+
+            order(gates);
+            flatten(gates);
+        }
+
+        //! Reset all states to zero.
+        void clear() {
+            std::fill(_sv.begin(), _sv.end(), 0);
+            std::fill(_svm1.begin(), _svm1.end(), 0);
+        }
+
+        //! Returns an iterator to the first output state.
+        iterator begin_output() {
+            return _sv.begin() + _nin;
+        }
+
+        //! Returns an iterator past the last output state.
+        iterator end_output() {
+            return _sv.begin() + _nin + _nout;
+        }
+
+        //! Update this network n times, with inputs [f, f+ninput_states()).
+        template <typename ForwardIterator>
+        void update(std::size_t n, ForwardIterator f) {
+            for( ; n>0; --n) {
+                _sv.swap(_svm1);
+                std::copy(f, f+_nin, _svm1.begin());
+                std::fill(_sv.begin(), _sv.end(), 0);
+                for(std::size_t i=0; i<_gates.size(); ++i) {
+                    const gate& g=_gates[i];
+                    word_type x=0;
+                    for(word_type j=0; j<g.nin; ++j) {
+                        x |= static_cast<word_type>(_svm1[_wiring[g.in+j]] & 0x01) << j;
+                    }
+                    word_type y;
+                    if(g.kind == LOGIC) {
+                        y = _tables[g.table + x];
+                    } else {
+                        word_type ncols=(1u << g.nout) - 1;
+                        y = sample(&_tables[g.table + x*ncols], ncols, random_word());
+                    }
+                    for(word_type j=0; j<g.nout; ++j) {
+                        _sv[_wiring[g.out+j]] |= (y >> j) & 0x01;
+                    }
+                }
+            }
+        }
+
+        /*! Returns the output pattern selected by random word r from a row of
+         n cumulative thresholds: the number of thresholds r is not below.
+         */
+        static word_type sample(const word_type* row, word_type n, word_type r) {
+            word_type y=0;
+            for(word_type k=0; k<n; ++k) {
+                y += (r >= row[k]);
+            }
+            return y;
+        }
+
+    protected:
+        /*! A gate under optimization.  A logic gate's table has one output
+         pattern per row; a probabilistic gate's has 2^nout weights per row,
+         summing to 2^32.
+         */
+        struct expanded_gate {
+            gate_kind kind;
+            std::vector<word_type> in; //!< Input states.
+            std::vector<word_type> out; //!< Output states.
+            std::vector<boost::uint64_t> table; //!< Table.
+            std::size_t depth; //!< Distance from the inputs.
+
+            //! Returns the number of table entries per row.
+            std::size_t width() const {
+                return (kind == LOGIC) ? 1 : (static_cast<std::size_t>(1) << out.size());
+            }
+        };
+
+        //! Mark the live states: the outputs, and those read by live gates.
+        void mark_live(std::vector<char>& live) const {
+            std::vector<std::vector<std::size_t> > writers(_sv.size());
+            for(std::size_t i=0; i<_gates.size(); ++i) {
+                for(word_type j=0; j<_gates[i].nout; ++j) {
+                    writers[_wiring[_gates[i].out+j]].push_back(i);
+                }
+            }
+            std::vector<char> done(_gates.size(), 0);
+            std::vector<word_type> pending;
+            for(std::size_t i=_nin; i<_nin+_nout; ++i) {
+                live[i] = 1;
+                pending.push_back(i);
+            }
+            while(!pending.empty()) {
+                word_type s=pending.back();
+                pending.pop_back();
+                if(s < _nin) {
+                    continue;
+                }
+                for(std::size_t k=0; k<writers[s].size(); ++k) {
+                    const gate& g=_gates[writers[s][k]];
+                    if(done[writers[s][k]]) {
+                        continue;
+                    }
+                    done[writers[s][k]] = 1;
+                    for(word_type j=0; j<g.nin; ++j) {
+                        word_type t=_wiring[g.in+j];
+                        if(!live[t]) {
+                            live[t] = 1;
+                            pending.push_back(t);
+                        }
+                    }
+                }
+            }
+        }
+
+        //! Returns the expanded form of compiled gate g.
+        expanded_gate expand(const gate& g) const {
+            expanded_gate e;
+            e.kind = g.kind;
+            e.in.assign(_wiring.begin()+g.in, _wiring.begin()+g.in+g.nin);
+            e.out.assign(_wiring.begin()+g.out, _wiring.begin()+g.out+g.nout);
+            e.depth = 0;
+            std::size_t rows=static_cast<std::size_t>(1) << g.nin;
+            if(g.kind == LOGIC) {
+                e.table.assign(_tables.begin()+g.table, _tables.begin()+g.table+rows);
+            } else {
+                std::size_t ncols=(static_cast<std::size_t>(1) << g.nout) - 1;
+                for(std::size_t x=0; x<rows; ++x) {
+                    boost::uint64_t last=0;
+                    for(std::size_t k=0; k<ncols; ++k) {
+                        boost::uint64_t t=_tables[g.table + x*ncols + k];
+                        e.table.push_back(t - last);
+                        last = t;
+                    }
+                    e.table.push_back((static_cast<boost::uint64_t>(1) << 32) - last);
+                }
+            }
+            return e;
+        }
+
+        //! Returns v with bit j removed.
+        static std::size_t remove_bit(std::size_t v, std::size_t j) {
+            return (v & ((static_cast<std::size_t>(1) << j) - 1)) | ((v >> (j+1)) << j);
+        }
+
+        //! Remove output j of g, marginalizing it out of g's table.
+        static void drop_output(expanded_gate& g, std::size_t j) {
+            if(g.kind == LOGIC) {
+                for(std::size_t x=0; x<g.table.size(); ++x) {
+                    g.table[x] = remove_bit(g.table[x], j);
+                }
+            } else {
+                std::size_t w=g.width(), rows=g.table.size() / w;
+                std::vector<boost::uint64_t> t(rows * w/2, 0);
+                for(std::size_t x=0; x<rows; ++x) {
+                    for(std::size_t y=0; y<w; ++y) {
+                        t[x*(w/2) + remove_bit(y, j)] += g.table[x*w + y];
+                    }
+                }
+                g.table.swap(t);
+            }
+            g.out.erase(g.out.begin() + j);
+        }
+
+        //! Remove input j of g, which is always zero, from g's table.
+        static void drop_input(expanded_gate& g, std::size_t j) {
+            std::size_t w=g.width(), rows=g.table.size() / w;
+            std::vector<boost::uint64_t> t;
+            for(std::size_t x=0; x<rows; ++x) {
+                if(((x >> j) & 0x01) == 0) {
+                    t.insert(t.end(), g.table.begin() + x*w, g.table.begin() + (x+1)*w);
+                }
+            }
+            g.table.swap(t);
+            g.in.erase(g.in.begin() + j);
+        }
+
+        //! Returns the position of s in v.
+        static std::size_t position(const std::vector<word_type>& v, word_type s) {
+            return std::find(v.begin(), v.end(), s) - v.begin();
+        }
+
+        /*! Merge logic gate b into logic gate a, if they write the same set of
+         states and the merged gate has at most max_inputs inputs; returns true
+         if they were merged.
+         */
+        static bool merge(expanded_gate& a, const expanded_gate& b, std::size_t max_inputs) {
+            if(a.kind != LOGIC || b.kind != LOGIC) {
+                return false;
+            }
+            std::vector<word_type> ao(a.out), bo(b.out);
+            std::sort(ao.begin(), ao.end());
+            ao.erase(std::unique(ao.begin(), ao.end()), ao.end());
+            std::sort(bo.begin(), bo.end());
+            bo.erase(std::unique(bo.begin(), bo.end()), bo.end());
+            if(ao != bo) {
+                return false;
+            }
+            std::vector<word_type> in;
+            for(std::size_t j=0; j<a.in.size(); ++j) {
+                if(position(in, a.in[j]) == in.size()) {
+                    in.push_back(a.in[j]);
+                }
+            }
+            for(std::size_t j=0; j<b.in.size(); ++j) {
+                if(position(in, b.in[j]) == in.size()) {
+                    in.push_back(b.in[j]);
+                }
+            }
+            if(in.size() > max_inputs) {
+                return false;
+            }
+            std::vector<boost::uint64_t> t(static_cast<std::size_t>(1) << in.size());
+            for(std::size_t x=0; x<t.size(); ++x) {
+                std::size_t xa=0, xb=0;
+                for(std::size_t j=0; j<a.in.size(); ++j) {
+                    xa |= ((x >> position(in, a.in[j])) & 0x01) << j;
+                }
+                for(std::size_t j=0; j<b.in.size(); ++j) {
+                    xb |= ((x >> position(in, b.in[j])) & 0x01) << j;
+                }
+                boost::uint64_t y=a.table[xa];
+                for(std::size_t k=0; k<b.out.size(); ++k) {
+                    y |= ((b.table[xb] >> k) & 0x01) << position(a.out, b.out[k]);
+                }
+                t[x] = y;
+            }
+            a.in.swap(in);
+            a.table.swap(t);
+            return true;
+        }
+
+        //! Used to order gates by distance from the inputs, then by first output.
+        struct depth_order {
+            bool operator()(const expanded_gate& a, const expanded_gate& b) const {
+                if(a.depth != b.depth) {
+                    return a.depth < b.depth;
+                }
+                word_type fa=a.out.empty() ? 0 : *std::min_element(a.out.begin(), a.out.end());
+                word_type fb=b.out.empty() ? 0 : *std::min_element(b.out.begin(), b.out.end());
+                return fa < fb;
+            }
+        };
+
+        /*! Order gates by their distance from the inputs; gates that depend on
+         the inputs only through a cycle of hidden states come last.
+         */
+        void order(std::vector<expanded_gate>& gates) const {
+            std::size_t unreached=gates.size() + 1;
+            std::vector<std::size_t> depth(_sv.size(), unreached);
+            for(std::size_t i=0; i<_nin; ++i) {
+                depth[i] = 0;
+            }
+            for(std::size_t i=0; i<gates.size(); ++i) {
+                gates[i].depth = unreached;
+            }
+            // relax until no gate's depth changes; gates are few, and each pass
+            // settles at least one more level:
+            for(bool changed=true; changed; ) {
+                changed = false;
+                for(std::size_t i=0; i<gates.size(); ++i) {
+                    expanded_gate& g=gates[i];
+                    std::size_t d=g.in.empty() ? 1 : unreached;
+                    for(std::size_t j=0; j<g.in.size(); ++j) {
+                        d = std::min(d, depth[g.in[j]] + 1);
+                    }
+                    if(d < g.depth) {
+                        g.depth = d;
+                        changed = true;
+                        for(std::size_t j=0; j<g.out.size(); ++j) {
+                            depth[g.out[j]] = std::min(depth[g.out[j]], d);
+                        }
+                    }
+                }
+            }
+            std::stable_sort(gates.begin(), gates.end(), depth_order());
+        }
+
+        //! Replace this network's gates with gates, renumbering hidden states.
+        void flatten(const std::vector<expanded_gate>& gates) {
+            std::vector<word_type> renumber(_sv.size(), 0);
+            for(std::size_t i=0; i<_nin+_nout; ++i) {
+                renumber[i] = i;
+            }
+            std::size_t n=_nin + _nout;
+            for(std::size_t i=0; i<gates.size(); ++i) {
+                for(std::size_t j=0; j<gates[i].out.size(); ++j) {
+                    word_type s=gates[i].out[j];
+                    if(s >= _nin+_nout && renumber[s] == 0) {
+                        renumber[s] = n++;
+                    }
+                }
+            }
+
+            _gates.clear();
+            _wiring.clear();
+            _tables.clear();
+            _nprob = 0;
+            for(std::size_t i=0; i<gates.size(); ++i) {
+                const expanded_gate& e=gates[i];
+                std::vector<word_type> in(e.in.size()), out(e.out.size());
+                for(std::size_t j=0; j<in.size(); ++j) {
+                    in[j] = renumber[e.in[j]];
+                }
+                for(std::size_t j=0; j<out.size(); ++j) {
+                    out[j] = renumber[e.out[j]];
+                }
+                add_gate(e.kind, in, out);
+                if(e.kind == LOGIC) {
+                    _tables.insert(_tables.end(), e.table.begin(), e.table.end());
+                } else {
+                    std::size_t w=e.width();
+                    for(std::size_t x=0; x<e.table.size(); x+=w) {
+                        boost::uint64_t c=0;
+                        for(std::size_t k=0; k+1<w; ++k) {
+                            c += e.table[x+k];
+                            _tables.push_back(static_cast<word_type>(std::min<boost::uint64_t>(c, 0xffffffffu)));
+                        }
+                    }
+                    ++_nprob;
+                }
+            }
+            _sv.assign(n, 0);
+            _svm1.assign(n, 0);
+        }
+
+        //! Append a gate of kind k with the given inputs and outputs.
+        template <typename IndexList>
+        void add_gate(gate_kind k, const IndexList& inputs, const IndexList& outputs) {
+            gate g;
+            g.kind = k;
+            g.in = _wiring.size();
+            g.nin = inputs.size();
+            _wiring.insert(_wiring.end(), inputs.begin(), inputs.end());
+            g.out = _wiring.size();
+            g.nout = outputs.size();
+            _wiring.insert(_wiring.end(), outputs.begin(), outputs.end());
+            g.table = _tables.size();
+            _gates.push_back(g);
+        }
+
+        /*! Append the integer thresholds of a row of probabilities (which need
+         not sum to one; a row of zeros is uniform).
+         */
+        void add_thresholds(const std::vector<double>& row) {
+            double total=0.0;
+            for(std::size_t k=0; k<row.size(); ++k) {
+                total += std::max(0.0, row[k]);
+            }
+            double c=0.0;
+            for(std::size_t k=0; k+1<row.size(); ++k) {
+                c += (total > 0.0) ? (std::max(0.0, row[k]) / total) : (1.0 / row.size());
+                _tables.push_back(static_cast<word_type>(std::min(4294967295.0, std::floor(c * 4294967296.0))));
+            }
+        }
+
+        //! Returns the next random word of the pool, refilling it if needed.
+        word_type random_word() {
+            if(_next == _pool.size()) {
+                _rng.fill(&_pool[0], _pool.size());
+                _next = 0;
+            }
+            return _pool[_next++];
+        }
+
+        std::size_t _nin; //!< Number of input states.
+        std::size_t _nout; //!< Number of output states.
+        std::size_t _nprob; //!< Number of probabilistic gates.
+        std::vector<state_type> _sv; //!< States at time t.
+        std::vector<state_type> _svm1; //!< States at time t-1.
+        std::vector<gate> _gates; //!< Gates, in order of execution.
+        std::vector<word_type> _wiring; //!< Input and output states of all gates.
+        std::vector<word_type> _tables; //!< Tables of all gates.
+        ealib::counter_rng _rng; //!< Source of random words.
+        std::vector<word_type> _pool; //!< Random words for probabilistic gates.
+        std::size_t _next; //!< Next unused word of the pool.
+    };
+
+    //! Update net n times, with inputs starting at f.
+    template <typename ForwardIterator>
+    void update(compiled_network& net, std::size_t n, ForwardIterator f) {
+        net.update(n, f);
+    }
+
+    /*! Returns true if net, updated n times in all, is expected to run faster
+     compiled and optimized than as is.
+
+     Compiling and optimizing cost about as much as 160 updates of a small
+     network, plus half an update per gate, since the optimizer's cost grows
+     faster than linearly in the number of gates; a compiled update is about
+     twice as fast as a decoded one.  (Measured against a libmkv-style gate
+     loop on networks of 8 to 512 gates.)  A network evaluated for only a few
+     updates is therefore cheaper to run as decoded.
+     */
+    inline bool worth_compiling(markov_network& net, std::size_t n) {
+        std::size_t ngates=static_cast<std::size_t>(std::distance(net.begin(), net.end()));
+        return n >= 160 + ngates/2;
+    }
+
+} // mkv
+
+#endif
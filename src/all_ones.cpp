@@ -20,7 +20,15 @@
 #include <ea/evolutionary_algorithm.h>
 #include <ea/representations/bitstring.h>
 #include <ea/cmdline_interface.h>
+#include <ea/sweep.h>
 #include <ea/datafiles/fitness.h>
+#include <ea/datafiles/async_fitness.h>
+#include <ea/datafiles/live_metrics.h>
+#include <ea/datafiles/phase_breakdown.h>
+#include <ea/profiled.h>
+#include <ea/selection/fenwick_proportionate.h>
+#include <ea/selection/batched_tournament.h>
+#include <ea/selection/batch_evaluated.h>
 using namespace ealib;
 
 
@@ -31,6 +39,26 @@ struct all_ones : public fitness_function<unary_fitness<double> > {
     double operator()(Individual& ind, EA& ea) {
         return static_cast<double>(std::count(ind.repr().begin(), ind.repr().end(), 1u));
     }
+
+    //! Genomes are scored in batches, one byte per site, site-major.
+    typedef genome_batch<boost::uint8_t, SITE_MAJOR> batch_type;
+
+    /*! Score all the genomes in b at once.  Each site of all genomes is
+     contiguous, so this is a single streaming pass of vector adds.
+     */
+    template <typename EA>
+    void evaluate_batch(const batch_type& b, double* f, EA& ea) {
+        std::vector<boost::uint32_t> ones(b.size(), 0);
+        for(std::size_t j=0; j<b.length(); ++j) {
+            const boost::uint8_t* s=b.vector(j);
+            for(std::size_t i=0; i<b.size(); ++i) {
+                ones[i] += s[i];
+            }
+        }
+        for(std::size_t i=0; i<b.size(); ++i) {
+            f[i] = static_cast<double>(ones[i]);
+        }
+    }
 };
 
 
@@ -54,11 +82,13 @@ struct configuration : public abstract_configuration<EA> {
  */
 typedef evolutionary_algorithm<
 bitstring, // representation
-mutation::operators::per_site<mutation::site::bitflip>, // mutation operator
-all_ones, // fitness function
+mutation::profiled<mutation::operators::per_site<mutation::site::bitflip> >, // mutation operator
+profiled_fitness<all_ones>, // fitness function
 configuration, // user-defined configuration methods
-recombination::asexual, // recombination operator
-generational_models::steady_state<selection::proportionate< >, selection::tournament< > > // generational model
+recombination::profiled<recombination::asexual>, // recombination operator
+generational_models::steady_state<
+    selection::profiled<selection::fenwick_proportionate< > >,
+    selection::profiled<selection::batch_evaluated<selection::batched_tournament< > >, profiling::REPLACEMENT> > // generational model
 > ea_type;
 
 
@@ -81,14 +111,19 @@ public:
         add_option<CHECKPOINT_PREFIX>(this);
         add_option<RNG_SEED>(this);
         add_option<RECORDING_PERIOD>(this);
+        add_option<DATAFILE_BINARY>(this);
+        add_option<LIVE_METRICS_NAME>(this);
+        add_option<LIVE_METRICS_CAPACITY>(this);
     }
     
     //! Define events (e.g., datafiles) here.
     virtual void gather_events(EA& ea) {
-        add_event<datafiles::fitness>(this, ea);
+        add_event<datafiles::async_fitness>(this, ea);
+        add_event<datafiles::live_metrics>(this, ea);
+        add_event<datafiles::phase_breakdown>(this, ea);
     };
 };
 
 
 // This macro connects the cli defined above to the main() function provided by ealib.
-LIBEA_CMDLINE_INSTANCE(ea_type, cli);
+LIBEA_SWEEP_INSTANCE(ea_type, cli);
@@ -19,7 +19,11 @@
  */
 
 #include <ea/digital_evolution.h>
+#include <ea/digital_evolution/mailboxes.h>
+#include <ea/digital_evolution/merit_proportional.h>
 #include <ea/cmdline_interface.h>
+#include <ea/sweep.h>
+#include <ea/datafiles/phase_breakdown.h>
 using namespace ealib;
 
 /*! Configures an instance of digital evolution in a manner similar to Avida.
@@ -28,7 +32,7 @@ using namespace ealib;
  of the EQU logic task (bitwise equals).
  */
 template <typename EA>
-struct configuration : public abstract_configuration<EA> {
+struct configuration : public abstract_configuration<EA>, public mailbox_configuration {
     
     typedef typename EA::tasklib_type::task_ptr_type task_ptr_type;
     typedef typename EA::environment_type::resource_ptr_type resource_ptr_type;
@@ -49,9 +53,9 @@ struct configuration : public abstract_configuration<EA> {
         append_isa<swap>(ea);
         append_isa<inc>(ea);
         append_isa<dec>(ea);
-        append_isa<tx_msg>(ea);
-        append_isa<rx_msg>(ea);
-        append_isa<bc_msg>(ea);
+        append_isa<tx_mbox>(ea);
+        append_isa<rx_mbox>(ea);
+        append_isa<bc_mbox>(ea);
         append_isa<rotate>(ea);
         append_isa<rotate_cw>(ea);
         append_isa<rotate_ccw>(ea);
@@ -96,6 +100,9 @@ struct configuration : public abstract_configuration<EA> {
         task_nor->consumes(resG);
         task_xor->consumes(resH);
         task_equals->consumes(resI);
+        
+        // Create the mailboxes now, before any organism can run
+        this->initialize_mailboxes(ea);
     }
     
     //! Called to generate the initial EA population.
@@ -106,9 +113,13 @@ struct configuration : public abstract_configuration<EA> {
 
 
 /*! Artificial life simulation definition.
+ 
+ Organisms are given CPU cycles in proportion to the merit they earn by
+ performing tasks.
  */
 typedef digital_evolution<
-configuration
+configuration,
+merit_proportional
 > ea_type;
 
 
@@ -130,13 +141,16 @@ public:
         add_option<CHECKPOINT_PREFIX>(this);
         add_option<RNG_SEED>(this);
         add_option<RECORDING_PERIOD>(this);
+        add_option<MAILBOX_CAPACITY>(this);
+        add_option<MAILBOX_OVERFLOW>(this);
     }
     
     virtual void gather_tools() {
     }
     
     virtual void gather_events(EA& ea) {
+        add_event<datafiles::phase_breakdown>(this, ea);
     };
 };
 
-LIBEA_CMDLINE_INSTANCE(ea_type, cli);
\ No newline at end of file
+LIBEA_SWEEP_INSTANCE(ea_type, cli);
\ No newline at end of file
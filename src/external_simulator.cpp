@@ -0,0 +1,94 @@
+/* external_simulator.cpp
+ * 
+ * This file is part of EALib Examples.
+ * 
+ * Copyright 2012 David B. Knoester.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <ea/evolutionary_algorithm.h>
+#include <ea/representations/bitstring.h>
+#include <ea/cmdline_interface.h>
+#include <ea/sweep.h>
+#include <ea/datafiles/fitness.h>
+#include <ea/datafiles/phase_breakdown.h>
+#include <ea/profiled.h>
+#include <ea/fitness_functions/external_simulator.h>
+#include <ea/selection/fenwick_proportionate.h>
+#include <ea/selection/batched_tournament.h>
+#include <ea/selection/batch_evaluated.h>
+using namespace ealib;
+
+
+/*! User-defined configuration struct; called at various points during initialization
+ of the EA.
+ */
+template <typename EA>
+struct configuration : public abstract_configuration<EA> {    
+    //! Called to generate the initial population of random bitstrings.
+    void initial_population(EA& ea) {
+        generate_ancestors(ancestors::random_bitstring(), get<POPULATION_SIZE>(ea), ea);
+    }
+};
+
+
+/*! Evolutionary algorithm definition.  Fitness is computed by an external
+ simulator, the command for which is given by ea.fitness_function.simulator.command
+ (etc/external_simulator.cfg uses a shell loop that counts ones).  Replacement
+ is batch-evaluated, so that all of an update's offspring are simulated
+ concurrently.
+ */
+typedef evolutionary_algorithm<
+bitstring, // representation
+mutation::profiled<mutation::operators::per_site<mutation::site::bitflip> >, // mutation operator
+profiled_fitness<external_simulator< > >, // fitness function
+configuration, // user-defined configuration methods
+recombination::profiled<recombination::asexual>, // recombination operator
+generational_models::steady_state<
+    selection::profiled<selection::fenwick_proportionate< > >,
+    selection::profiled<selection::batch_evaluated<selection::batched_tournament< > >, profiling::REPLACEMENT> > // generational model
+> ea_type;
+
+
+/*! Define the EA's command-line interface.
+ */
+template <typename EA>
+class cli : public cmdline_interface<EA> {
+public:
+    //! Define the options that can be parsed.
+    virtual void gather_options() {
+        add_option<REPRESENTATION_SIZE>(this);
+        add_option<POPULATION_SIZE>(this);
+        add_option<REPLACEMENT_RATE_P>(this);
+        add_option<MUTATION_PER_SITE_P>(this);
+        add_option<TOURNAMENT_SELECTION_N>(this);
+        add_option<TOURNAMENT_SELECTION_K>(this);
+        add_option<RUN_UPDATES>(this);
+        add_option<RUN_EPOCHS>(this);
+        add_option<CHECKPOINT_PREFIX>(this);
+        add_option<RNG_SEED>(this);
+        add_option<RECORDING_PERIOD>(this);
+        add_option<DATAFILE_BINARY>(this);
+        add_option<SIMULATOR_COMMAND>(this);
+        add_option<SIMULATOR_CONCURRENCY>(this);
+        add_option<SIMULATOR_RETRIES>(this);
+    }
+    
+    //! Define events (e.g., datafiles) here.
+    virtual void gather_events(EA& ea) {
+        add_event<datafiles::fitness>(this, ea);
+        add_event<datafiles::phase_breakdown>(this, ea);
+    };
+};
+LIBEA_SWEEP_INSTANCE(ea_type, cli);
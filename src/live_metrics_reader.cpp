@@ -0,0 +1,87 @@
+/* live_metrics_reader.cpp
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <unistd.h>
+#include <ea/live_metrics_ring.h>
+using namespace ealib;
+
+/* Attaches to the shared-memory segment published by datafiles::live_metrics in
+ a running EA, and prints the statistics for its most recent updates.  This
+ program only reads the segment; it never slows down the EA being watched.
+
+ usage: live_metrics_reader <segment name> [n=10] [-f]
+
+ With -f, keep polling once per second and print new updates as they appear.
+ */
+void print(const metrics_record& r) {
+    std::cout << r.update << " "
+    << r.population_size << " "
+    << r.mean_fitness << " "
+    << r.min_fitness << " "
+    << r.max_fitness << std::endl;
+}
+
+int main(int argc, const char* argv[]) {
+    if(argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <segment name> [n=10] [-f]" << std::endl;
+        return -1;
+    }
+
+    std::size_t n=10;
+    bool follow=false;
+    for(int i=2; i<argc; ++i) {
+        if(std::strcmp(argv[i], "-f") == 0) {
+            follow = true;
+        } else {
+            n = static_cast<std::size_t>(std::atol(argv[i]));
+        }
+    }
+
+    try {
+        metrics_ring_reader reader(argv[1]);
+        std::vector<metrics_record> records;
+
+        std::cout << "update population_size mean_fitness min_fitness max_fitness" << std::endl;
+        reader.last(n, records);
+        for(std::size_t i=0; i<records.size(); ++i) {
+            print(records[i]);
+        }
+
+        boost::uint64_t seen=reader.count();
+        while(follow) {
+            sleep(1);
+            boost::uint64_t now=reader.count();
+            if(now > seen) {
+                reader.last(static_cast<std::size_t>(now-seen), records);
+                for(std::size_t i=0; i<records.size(); ++i) {
+                    print(records[i]);
+                }
+                seen = now;
+            }
+        }
+    } catch(std::exception& e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -20,8 +20,18 @@
 #include <ea/evolutionary_algorithm.h>
 #include <ea/representations/bitstring.h>
 #include <ea/cmdline_interface.h>
+#include <ea/sweep.h>
 #include <ea/datafiles/fitness.h>
+#include <ea/datafiles/async_fitness.h>
 #include <ea/line_of_descent.h>
+#include <ea/lod_stream.h>
+#include <ea/datafiles/phase_breakdown.h>
+#include <ea/datafiles/memory_usage.h>
+#include <ea/profiled.h>
+#include <ea/selection/fenwick_proportionate.h>
+#include <ea/selection/batched_tournament.h>
+#include <ea/fitness_functions/memoized.h>
+#include <ea/datafiles/fitness_cache.h>
 using namespace ealib;
 
 
@@ -58,10 +68,10 @@ struct configuration : public abstract_configuration<EA> {
 typedef evolutionary_algorithm<
 bitstring, // representation
 mutation::operators::per_site<mutation::site::bitflip>, // mutation operator
-all_ones, // fitness function
+memoized<all_ones>, // fitness function
 configuration, // user-defined configuration methods
 recombination::asexual, // recombination operator
-generational_models::steady_state<selection::proportionate< >, selection::tournament< > >, // generational model
+generational_models::steady_state<selection::fenwick_proportionate< >, selection::batched_tournament< > >, // generational model
 attr::default_attributes, // individual attributes
 individual_lod // using an lod individual automatically turns on LOD tracking.
 > ea_type;
@@ -86,16 +96,29 @@ public:
         add_option<CHECKPOINT_PREFIX>(this);
         add_option<RNG_SEED>(this);
         add_option<RECORDING_PERIOD>(this);
+        add_option<DATAFILE_BINARY>(this);
+        add_option<LOD_STREAM_FILE>(this);
+        add_option<LOD_STREAM_MAX_DISTANCE>(this);
+        add_option<FITNESS_CACHE_CAPACITY>(this);
+    }
+    
+    //! Define analysis tools here.
+    virtual void gather_tools() {
+        add_tool<analysis::lod_stream_analysis>(this);
     }
     
     //! Define events (e.g., datafiles) here.
     virtual void gather_events(EA& ea) {
-        add_event<datafiles::fitness>(this, ea);
-        add_event<lod_event>(this, ea);
+        add_event<datafiles::async_fitness>(this, ea);
+        add_event<accounted_lod_event>(this, ea);
         add_event<datafiles::mrca_lineage>(this, ea);
+        add_event<datafiles::lod_stream>(this, ea);
+        add_event<datafiles::phase_breakdown>(this, ea);
+        add_event<datafiles::memory_usage>(this, ea);
+        add_event<datafiles::fitness_cache>(this, ea);
     };
 };
 
 
 // This macro connects the cli defined above to the main() function provided by ealib.
-LIBEA_CMDLINE_INSTANCE(ea_type, cli);
+LIBEA_SWEEP_INSTANCE(ea_type, cli);
@@ -20,10 +20,29 @@
 #include <ea/evolutionary_algorithm.h>
 #include <ea/generational_models/death_birth_process.h>
 #include <ea/representations/circular_genome.h>
+#include <ea/representations/chunked_genome.h>
+#include <ea/representations/site_width.h>
 #include <ea/fitness_function.h>
 #include <ea/cmdline_interface.h>
+#include <ea/sweep.h>
 #include <ea/datafiles/fitness.h>
+#include <ea/datafiles/async_fitness.h>
+#include <ea/datafiles/live_metrics.h>
+#include <ea/datafiles/phase_breakdown.h>
+#include <ea/datafiles/memory_usage.h>
+#include <ea/profiled.h>
+#include <ea/fitness_functions/racing.h>
+#include <ea/fitness_functions/farmed.h>
+#include <ea/batch_fitness.h>
+#include <ea/selection/batch_evaluated.h>
+#include <ea/selection/prescreened.h>
+#include <ea/selection/fenwick_proportionate.h>
+#include <ea/selection/elitism.h>
+#include <ea/counter_rng.h>
+#include <ea/datafiles/racing.h>
+#include <ea/datafiles/prescreening.h>
 #include <ea/markov_network.h>
+#include <mkv/compiled_network.h>
 using namespace ealib;
 
 
@@ -31,52 +50,117 @@ using namespace ealib;
  */
 struct example_fitness : fitness_function<unary_fitness<double>, constantS, stochasticS> {
     
+    //! Constructor.
+    example_fitness() : _seed(0), _update(0), _k(0) {
+    }
+    
     /*! Initialize this fitness function -- load data, etc. */
     template <typename RNG, typename EA>
     void initialize(RNG& rng, EA& ea) {
+        check_site_width(ea);
+        _seed = get<RNG_SEED>(ea);
+        if(_seed == 0) {
+            _seed = rng.seed();
+        }
     }
     
+    typedef genome_batch<boost::uint16_t, POPULATION_MAJOR> batch_type;
+    
 	template <typename Individual, typename RNG, typename EA>
 	double operator()(Individual& ind, RNG& rng, EA& ea) {
-        using namespace mkv;
+        // each evaluation draws from its own counter-based stream, keyed by the
+        // seed, the update, and the index of the evaluation within the update:
+        if(ea.current_update() != _update) {
+            _update = ea.current_update();
+            _k = 0;
+        }
+        counter_rng trials(_seed, static_cast<boost::uint32_t>(_update), _k++);
         
-        markov_network net(make_markov_network_desc(get<MKV_DESC>(ea)), rng.seed());
-
-        // build a markov network from the individual's genome:
-        mkv::build_markov_network(net, ind.repr().begin(), ind.repr().end(), ea);
+        // build a markov network from the individual's genome, reading it
+        // through const iterators:
+        const typename Individual::representation_type& repr=ind.repr();
+        return evaluate(repr.begin(), repr.end(), trials, ea);
+    }
+    
+    /*! Evaluate a batch of genomes, possibly in another process (see
+     ea/fitness_functions/farmed.h).  Each genome's stream is keyed by its
+     position among the genomes batch-evaluated in its update, which does not
+     depend on how the batch was split up; the high bit keeps these streams
+     apart from those of one-at-a-time evaluations.
+     */
+    template <typename EA>
+    void evaluate_batch(const batch_type& b, double* f, EA& ea) {
+        for(std::size_t i=0; i<b.size(); ++i) {
+            counter_rng trials(_seed, static_cast<boost::uint32_t>(b.update()),
+                               static_cast<boost::uint32_t>(b.first() + i) | 0x80000000u);
+            f[i] = evaluate(b.vector(i), b.vector(i) + b.length(i), trials, ea);
+        }
+    }
+    
+    //! Most trials an evaluation runs (racing may stop it sooner).
+    static const std::size_t TRIALS=128;
+    
+    /*! Evaluate the network encoded by [f,l), drawing inputs from trials.
+     Networks are compiled and optimized when they will be updated often enough
+     to repay it (see mkv::worth_compiling).
+     */
+    template <typename ForwardIterator, typename EA>
+    double evaluate(ForwardIterator f, ForwardIterator l, counter_rng& trials, EA& ea) {
+        using namespace mkv;
         
+        markov_network net(make_markov_network_desc(get<MKV_DESC>(ea)), trials.seed());
+        mkv::build_markov_network(net, f, l, ea);
         
-        // now, set the values of the bits in the input vector:
-        double f=0.0;
-        for(std::size_t i=0; i<128; ++i) {
+        if(worth_compiling(net, TRIALS * get<MKV_UPDATE_N>(ea))) {
+            compiled_network cnet(trials.seed());
+            if(cnet.compile(net)) {
+                cnet.optimize();
+                return run_trials(cnet, trials, ea);
+            }
+        }
+        return run_trials(net, trials, ea);
+    }
+    
+    //! Run trials of the XOR task on net, returning fitness.
+    template <typename Network, typename EA>
+    double run_trials(Network& net, counter_rng& trials, EA& ea) {
+        // now, set the values of the bits in the input vector; trials are
+        // raced, so that networks that can no longer reach the threshold set
+        // by racing_threshold stop early:
+        race r(TRIALS, ea);
+        while(r.running()) {
             // allocate space for the inputs:
             std::vector<int> inputs;//(net.ninput_states(), 0);
-            inputs.push_back(rng.bit());
-            inputs.push_back(rng.bit());
+            inputs.push_back(trials.bit());
+            inputs.push_back(trials.bit());
             
             // update the network n times:
             net.clear();
             update(net, get<MKV_UPDATE_N>(ea), inputs.begin());
             
-            if(*net.begin_output() == (inputs[0] ^ inputs[1])) {
-                ++f;
-            }
+            r(*net.begin_output() == (inputs[0] ^ inputs[1]));
         }
 
-        // and return some measure of fitness:
-        return f;
+        // and return some measure of fitness, on the scale of TRIALS trials:
+        return TRIALS * r.mean();
     }
+    
+    boost::uint64_t _seed; //!< Seed of all evaluation streams.
+    unsigned long _update; //!< Update of the most recent evaluation.
+    boost::uint32_t _k; //!< Evaluations so far during _update.
 };
 
 
 //! Evolutionary algorithm definition.
 typedef evolutionary_algorithm<
-mkv::representation_type,
-mkv::mutation_type,
-example_fitness,
+chunked_genome<boost::uint16_t>,
+mutation::profiled<mkv::mutation_type>,
+prescreened_fitness<profiled_fitness<farmed<example_fitness> > >,
 mkv::markov_network_configuration,
-recombination::asexual,
-generational_models::death_birth_process< >
+recombination::profiled<recombination::asexual>,
+generational_models::death_birth_process<
+    selection::profiled<selection::batch_evaluated<selection::fenwick_proportionate< > > >,
+    selection::profiled<selection::prescreened<selection::batch_evaluated<selection::elitism<selection::random> > >, profiling::REPLACEMENT> >
 > ea_type;
 
 
@@ -113,11 +197,28 @@ public:
 
         add_option<POPULATION_SIZE>(this);
         add_option<REPLACEMENT_RATE_P>(this);
+        add_option<ELITISM_N>(this);
         add_option<RUN_UPDATES>(this);
         add_option<RUN_EPOCHS>(this);
         add_option<CHECKPOINT_PREFIX>(this);
         add_option<RNG_SEED>(this);
         add_option<RECORDING_PERIOD>(this);
+        add_option<DATAFILE_BINARY>(this);
+        add_option<LIVE_METRICS_NAME>(this);
+        add_option<LIVE_METRICS_CAPACITY>(this);
+        add_option<RACING_QUANTILE>(this);
+        add_option<RACING_DELTA>(this);
+        add_option<RACING_EXTRA_TRIALS>(this);
+        add_option<FARM_WORKERS>(this);
+        add_option<FARM_ADDRESS>(this);
+        add_option<FARM_CHUNK_SIZE>(this);
+        add_option<FARM_PIPELINE_DEPTH>(this);
+        add_option<PRESCREEN_FRACTION>(this);
+        add_option<PRESCREEN_WARMUP>(this);
+        add_option<PRESCREEN_AUDIT_P>(this);
+        add_option<PRESCREEN_KMER>(this);
+        add_option<PRESCREEN_FEATURES>(this);
+        add_option<PRESCREEN_LEARNING_RATE>(this);
     }
     
     
@@ -127,7 +228,13 @@ public:
     }
     
     virtual void gather_events(EA& ea) {
-        add_event<datafiles::fitness>(this, ea);
+        add_event<datafiles::async_fitness>(this, ea);
+        add_event<datafiles::live_metrics>(this, ea);
+        add_event<datafiles::phase_breakdown>(this, ea);
+        add_event<datafiles::memory_usage>(this, ea);
+        add_event<racing_threshold>(this, ea);
+        add_event<datafiles::racing>(this, ea);
+        add_event<datafiles::prescreening>(this, ea);
     };
 };
-LIBEA_CMDLINE_INSTANCE(ea_type, cli);
+LIBEA_SWEEP_INSTANCE(ea_type, cli);
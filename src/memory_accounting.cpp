@@ -0,0 +1,216 @@
+/* memory_accounting.cpp
+ *
+ * This file is part of EALib Examples.
+ *
+ * Copyright 2012 David B. Knoester.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <ea/memory_accounting.h>
+
+#ifdef LIBEA_MEMORY_ACCOUNTING
+#include <cstdlib>
+#include <new>
+
+/* Replacement global operator new and delete that charge every allocation to
+ the calling thread's current component (see ea/memory_accounting.h).
+
+ Each block is prefixed with a small header that records its size and the
+ component it was charged to, so that it can be credited back correctly when it
+ is freed, possibly by a different thread or from within a different scope.
+ The header is 16 bytes to preserve the alignment guaranteed by malloc.  Blocks
+ with a stricter alignment (C++17 aligned new) also record where the block
+ returned by malloc starts, just before the header.
+
+ Every form of operator new and delete that the language in use provides is
+ replaced: exception specifications before C++11, noexcept after, and the
+ sized (C++14) and aligned (C++17) forms where the compiler has them.
+ */
+#if __cplusplus >= 201103L
+#define LIBEA_THROWS_BAD_ALLOC
+#define LIBEA_NOTHROW noexcept
+#else
+#define LIBEA_THROWS_BAD_ALLOC throw(std::bad_alloc)
+#define LIBEA_NOTHROW throw()
+#endif
+
+namespace {
+    struct block_header {
+        std::size_t size;
+        std::size_t component;
+    };
+
+    const std::size_t header_size=16;
+
+    //! Record n bytes at q, which is preceded by room for a header, and charge them.
+    void* charge_block(char* q, std::size_t n) {
+        block_header* h=reinterpret_cast<block_header*>(q - header_size);
+        h->size = n;
+        h->component = static_cast<std::size_t>(ealib::memory::current_component());
+        ealib::memory::charge(static_cast<int>(h->component), static_cast<boost::int64_t>(n));
+        return q;
+    }
+
+    //! Credit the block at q back to the component it was charged to.
+    void credit_block(void* q) {
+        block_header* h=reinterpret_cast<block_header*>(static_cast<char*>(q) - header_size);
+        ealib::memory::credit(static_cast<int>(h->component), static_cast<boost::int64_t>(h->size));
+    }
+
+    void* accounted_alloc(std::size_t n) {
+        char* p=static_cast<char*>(std::malloc(n + header_size));
+        if(p == 0) {
+            throw std::bad_alloc();
+        }
+        return charge_block(p + header_size, n);
+    }
+
+    void accounted_free(void* q) {
+        if(q == 0) {
+            return;
+        }
+        credit_block(q);
+        std::free(static_cast<char*>(q) - header_size);
+    }
+
+#if defined(__cpp_aligned_new)
+    /*! Allocate n bytes aligned to a; the block returned by malloc is recorded
+     just before the header.
+     */
+    void* accounted_aligned_alloc(std::size_t n, std::size_t a) {
+        if(a < header_size) {
+            a = header_size;
+        }
+        const std::size_t prefix=header_size + sizeof(char*);
+        char* p=static_cast<char*>(std::malloc(n + prefix + a));
+        if(p == 0) {
+            throw std::bad_alloc();
+        }
+        std::size_t x=reinterpret_cast<std::size_t>(p) + prefix;
+        char* q=reinterpret_cast<char*>((x + a - 1) & ~(a - 1));
+        *reinterpret_cast<char**>(q - prefix) = p;
+        return charge_block(q, n);
+    }
+
+    void accounted_aligned_free(void* q) {
+        if(q == 0) {
+            return;
+        }
+        credit_block(q);
+        std::free(*reinterpret_cast<char**>(static_cast<char*>(q) - header_size - sizeof(char*)));
+    }
+#endif
+}
+
+void* operator new(std::size_t n) LIBEA_THROWS_BAD_ALLOC {
+    return accounted_alloc(n);
+}
+
+void* operator new[](std::size_t n) LIBEA_THROWS_BAD_ALLOC {
+    return accounted_alloc(n);
+}
+
+void* operator new(std::size_t n, const std::nothrow_t&) LIBEA_NOTHROW {
+    try {
+        return accounted_alloc(n);
+    } catch(std::bad_alloc&) {
+        return 0;
+    }
+}
+
+void* operator new[](std::size_t n, const std::nothrow_t&) LIBEA_NOTHROW {
+    try {
+        return accounted_alloc(n);
+    } catch(std::bad_alloc&) {
+        return 0;
+    }
+}
+
+void operator delete(void* p) LIBEA_NOTHROW {
+    accounted_free(p);
+}
+
+void operator delete[](void* p) LIBEA_NOTHROW {
+    accounted_free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) LIBEA_NOTHROW {
+    accounted_free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) LIBEA_NOTHROW {
+    accounted_free(p);
+}
+
+#if defined(__cpp_sized_deallocation)
+void operator delete(void* p, std::size_t) LIBEA_NOTHROW {
+    accounted_free(p);
+}
+
+void operator delete[](void* p, std::size_t) LIBEA_NOTHROW {
+    accounted_free(p);
+}
+#endif
+
+#if defined(__cpp_aligned_new)
+void* operator new(std::size_t n, std::align_val_t a) {
+    return accounted_aligned_alloc(n, static_cast<std::size_t>(a));
+}
+
+void* operator new[](std::size_t n, std::align_val_t a) {
+    return accounted_aligned_alloc(n, static_cast<std::size_t>(a));
+}
+
+void* operator new(std::size_t n, std::align_val_t a, const std::nothrow_t&) noexcept {
+    try {
+        return accounted_aligned_alloc(n, static_cast<std::size_t>(a));
+    } catch(std::bad_alloc&) {
+        return 0;
+    }
+}
+
+void* operator new[](std::size_t n, std::align_val_t a, const std::nothrow_t&) noexcept {
+    try {
+        return accounted_aligned_alloc(n, static_cast<std::size_t>(a));
+    } catch(std::bad_alloc&) {
+        return 0;
+    }
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    accounted_aligned_free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+    accounted_aligned_free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    accounted_aligned_free(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+    accounted_aligned_free(p);
+}
+
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    accounted_aligned_free(p);
+}
+
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    accounted_aligned_free(p);
+}
+#endif
+
+#endif
@@ -20,13 +20,23 @@
 #include <ea/evolutionary_algorithm.h>
 #include <ea/generational_models/death_birth_process.h>
 #include <ea/representations/circular_genome.h>
+#include <ea/representations/chunked_genome.h>
+#include <ea/representations/site_width.h>
 #include <ea/fitness_function.h>
 #include <ea/cmdline_interface.h>
+#include <ea/sweep.h>
 #include <ea/datafiles/fitness.h>
 #include <ea/markov_network.h>
+#include <mkv/compiled_network.h>
+#include <ea/counter_rng.h>
 #include <ea/meta_population.h>
 #include <ea/island_model.h>
 #include <ea/selection/elitism.h>
+#include <ea/datafiles/async_meta_population_fitness.h>
+#include <ea/datafiles/phase_breakdown.h>
+#include <ea/datafiles/memory_usage.h>
+#include <ea/profiled.h>
+#include <ea/selection/fenwick_proportionate.h>
 using namespace ealib;
 
 /* This example defines an island model GA, where each individual represents a
@@ -40,44 +50,90 @@ using namespace ealib;
  */
 struct example_fitness : fitness_function<unary_fitness<double>, constantS, stochasticS> {
     
+    //! Constructor.
+    example_fitness() : _seed(0), _update(0), _k(0) {
+    }
+    
     /*! Initialize this fitness function -- load data, etc. */
     template <typename RNG, typename EA>
     void initialize(RNG& rng, EA& ea) {
+        check_site_width(ea);
+        // each island draws its own seed, once:
+        _seed = rng.seed();
     }
     
 	template <typename Individual, typename RNG, typename EA>
 	double operator()(Individual& ind, RNG& rng, EA& ea) {
         using namespace mkv;
         
-        markov_network net(make_markov_network_desc(get<MKV_DESC>(ea)), rng);
+        // each evaluation draws from its own counter-based stream, keyed by the
+        // seed, the update, and the index of the evaluation within the update,
+        // so that it takes nothing from the EA's random number generator:
+        if(ea.current_update() != _update) {
+            _update = ea.current_update();
+            _k = 0;
+        }
+        counter_rng stream(_seed, static_cast<boost::uint32_t>(_update), _k++);
+        
+        markov_network net(make_markov_network_desc(get<MKV_DESC>(ea)), stream.seed());
         
-        // build a markov network from the individual's genome:
-        mkv::build_markov_network(net, ind.repr().begin(), ind.repr().end(), ea);
+        // build a markov network from the individual's genome, reading it
+        // through const iterators:
+        const typename Individual::representation_type& repr=ind.repr();
+        mkv::build_markov_network(net, repr.begin(), repr.end(), ea);
         
         // allocate space for the inputs & outputs:
         std::vector<int> inputs(net.ninput_states(), 0);
+        std::vector<int> outputs;
         
         // now, set the values of the bits in the input vector:
         
-        // update the network n times:
-        update(net, get<MKV_UPDATE_N>(ea), inputs.begin());
+        // update the network n times, in compiled form if that will pay off;
+        // outputs are read from whichever network ran:
+        bool compiled=false;
+        if(worth_compiling(net, get<MKV_UPDATE_N>(ea))) {
+            compiled_network cnet(stream.seed());
+            if(cnet.compile(net)) {
+                cnet.optimize();
+                run(cnet, get<MKV_UPDATE_N>(ea), inputs.begin(), outputs);
+                compiled = true;
+            }
+        }
+        if(!compiled) {
+            run(net, get<MKV_UPDATE_N>(ea), inputs.begin(), outputs);
+        }
         
-        // calculate fitness based on the outputs...
+        // calculate fitness based on outputs...
         
         // and return some measure of fitness:
         return 1.0;
     }
+    
+    /*! Update net n times, with inputs starting at f, and copy its outputs
+     into outputs; net may be decoded or compiled.
+     */
+    template <typename Network, typename ForwardIterator>
+    void run(Network& net, std::size_t n, ForwardIterator f, std::vector<int>& outputs) {
+        update(net, n, f);
+        outputs.assign(net.begin_output(), net.end_output());
+    }
+    
+    boost::uint64_t _seed; //!< Seed of all evaluation streams.
+    unsigned long _update; //!< Update of the most recent evaluation.
+    boost::uint32_t _k; //!< Evaluations so far during _update.
 };
 
 
 //! Evolutionary algorithm definition (one island).
 typedef evolutionary_algorithm<
-mkv::representation_type,
-mkv::mutation_type,
-example_fitness,
+chunked_genome<boost::uint16_t>,
+mutation::profiled<mkv::mutation_type>,
+profiled_fitness<example_fitness>,
 mkv::markov_network_configuration,
-recombination::asexual,
-generational_models::death_birth_process<selection::proportionate< >, selection::elitism<selection::random> >
+recombination::profiled<recombination::asexual>,
+generational_models::death_birth_process<
+    selection::profiled<selection::fenwick_proportionate< > >,
+    selection::profiled<selection::elitism<selection::random>, profiling::REPLACEMENT> >
 > ea_type;
 
 
@@ -132,6 +188,7 @@ public:
         add_option<CHECKPOINT_PREFIX>(this);
         add_option<RNG_SEED>(this);
         add_option<RECORDING_PERIOD>(this);
+        add_option<DATAFILE_BINARY>(this);
         add_option<META_POPULATION_SIZE>(this);
         add_option<ISLAND_MIGRATION_PERIOD>(this);
         add_option<ISLAND_MIGRATION_RATE>(this);
@@ -139,8 +196,10 @@ public:
     }
     
     virtual void gather_events(EA& ea) {
-        add_event<island_model>(this, ea);
-        add_event<datafiles::meta_population_fitness>(this, ea);
+        add_event<profiled_island_model>(this, ea);
+        add_event<datafiles::async_meta_population_fitness>(this, ea);
+        add_event<datafiles::phase_breakdown>(this, ea);
+        add_event<datafiles::meta_population_memory_usage>(this, ea);
     };
 };
-LIBEA_CMDLINE_INSTANCE(mp_type, cli);
+LIBEA_SWEEP_INSTANCE(mp_type, cli);
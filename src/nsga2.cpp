@@ -22,8 +22,13 @@
 #include <ea/generational_models/qhfc.h>
 #include <ea/representations/bitstring.h>
 #include <ea/cmdline_interface.h>
+#include <ea/sweep.h>
 #include <ea/fitness_functions/all_ones.h>
 #include <ea/generational_models/nsga2.h>
+#include <ea/datafiles/phase_breakdown.h>
+#include <ea/profiled.h>
+#include <ea/fitness_functions/memoized.h>
+#include <ea/datafiles/fitness_cache.h>
 using namespace ealib;
 
 /*! User-defined configuration struct; called at various points during initialization
@@ -42,10 +47,10 @@ struct configuration : public abstract_configuration<EA> {
 
 typedef evolutionary_algorithm<
 bitstring,
-mutation::operators::per_site<mutation::site::bitflip>, // mutation operator
-multi_all_ones,
+mutation::profiled<mutation::operators::per_site<mutation::site::bitflip> >, // mutation operator
+profiled_fitness<memoized<multi_all_ones> >,
 configuration,
-recombination::two_point_crossover,
+recombination::profiled<recombination::two_point_crossover>,
 generational_models::nsga2,
 nsga2_attributes
 > ea_type;
@@ -68,9 +73,12 @@ public:
         add_option<CHECKPOINT_PREFIX>(this);
         add_option<RNG_SEED>(this);
         add_option<RECORDING_PERIOD>(this);
+        add_option<FITNESS_CACHE_CAPACITY>(this);
     }
     
     virtual void gather_events(EA& ea) {
+        add_event<datafiles::phase_breakdown>(this, ea);
+        add_event<datafiles::fitness_cache>(this, ea);
     };
 };
-LIBEA_CMDLINE_INSTANCE(ea_type, cli);
+LIBEA_SWEEP_INSTANCE(ea_type, cli);
@@ -22,6 +22,11 @@
 #include <ea/generational_models/qhfc.h>
 #include <ea/representations/bitstring.h>
 #include <ea/cmdline_interface.h>
+#include <ea/sweep.h>
+#include <ea/datafiles/async_qhfc.h>
+#include <ea/datafiles/phase_breakdown.h>
+#include <ea/fitness_functions/memoized.h>
+#include <ea/datafiles/fitness_cache.h>
 using namespace ealib;
 
 /*! Fitness function that rewards for the number of ones in the genome.
@@ -55,7 +60,7 @@ struct configuration : public abstract_configuration<EA> {
 typedef evolutionary_algorithm<
 bitstring,
 mutation::operators::per_site<mutation::site::bitflip>, // mutation operator
-all_ones,
+memoized<all_ones>,
 configuration,
 recombination::two_point_crossover,
 generational_models::deterministic_crowding< > > ea_type;
@@ -89,10 +94,14 @@ public:
         add_option<CHECKPOINT_PREFIX>(this);
         add_option<RNG_SEED>(this);
         add_option<RECORDING_PERIOD>(this);
+        add_option<DATAFILE_BINARY>(this);
+        add_option<FITNESS_CACHE_CAPACITY>(this);
     }
     
     virtual void gather_events(EA& ea) {
-        add_event<datafiles::qhfc>(this, ea);
+        add_event<datafiles::async_qhfc>(this, ea);
+        add_event<datafiles::phase_breakdown>(this, ea);
+        add_event<datafiles::fitness_cache>(this, ea);
     };
 };
-LIBEA_CMDLINE_INSTANCE(mea_type, cli);
+LIBEA_SWEEP_INSTANCE(mea_type, cli);
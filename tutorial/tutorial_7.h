@@ -0,0 +1,262 @@
+#ifndef _TUTORIAL_7_H_
+#define _TUTORIAL_7_H_
+
+/* Bring in our previous work...
+ */
+#include <cstring>
+#include <stdint.h>
+#include "tutorial_6.h"
+
+/* The EA from part 6 is correct, and it's generic.  But it isn't fast, and it
+ isn't hard to see why.  Every update, it:
+
+ - stores each individual as a vector<int>, which spends 32 bits on a single bit
+ of information, and puts every individual in its own separately allocated block
+ of memory;
+ - copies offspring into a brand new population, and then copies them again
+ when they're inserted into p;
+ - shuffles the whole population, twice, which moves every vector around;
+ - erases the tail of the population, which frees all those vectors;
+ - and, in compete(), builds yet another population by copying.
+
+ None of that has anything to do with evolution.  So, in this part, we'll keep
+ the *same* EA, with the same interface as generic_mutate and generic_random_selection,
+ but build it on a population engine that never allocates once it's been created.
+
+ First, we need a better random number generator than rand().  This one is
+ xorshift128+: it's tiny, it's fast, and its output is far better than rand()'s:
+ */
+class xorshift128plus {
+public:
+    xorshift128plus(uint64_t seed=42) {
+        // expand the seed into the two words of state with splitmix64, so that
+        // similar seeds don't give similar streams:
+        for(int i=0; i<2; ++i) {
+            uint64_t z=(seed += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            _s[i] = z ^ (z >> 31);
+        }
+    }
+
+    //! Returns 64 random bits.
+    uint64_t operator()() {
+        uint64_t s1=_s[0];
+        const uint64_t s0=_s[1];
+        _s[0] = s0;
+        s1 ^= s1 << 23;
+        _s[1] = s1 ^ s0 ^ (s1 >> 17) ^ (s0 >> 26);
+        return _s[1] + s0;
+    }
+
+    //! Returns a uniform double in [0,1).
+    double uniform() {
+        return ((*this)() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    //! Returns a uniform integer in [0,n), for n < 2^32.
+    size_t below(size_t n) {
+        return static_cast<size_t>((((*this)() >> 32) * n) >> 32);
+    }
+
+private:
+    uint64_t _s[2];
+};
+
+/* Next, the population itself.  Rather than a vector of vectors, it's a single
+ matrix of bits: row i is individual i, packed 64 sites to a word.  Fitness
+ (the number of ones) is then just a popcount of each word.
+
+ The matrix has a few more rows than the population: these "spare" rows are
+ where offspring are built, so that making an offspring is a copy from one row
+ to another, and not an allocation.  The engine also keeps two permutations of
+ row indices, which selection and replacement shuffle in place, and a little
+ scratch space for compete().  All of it is allocated once, right here:
+ */
+class packed_population {
+public:
+    typedef uint64_t word_type;
+
+    packed_population(size_t n, size_t l, size_t spare, uint64_t seed=42)
+    : _n(n), _l(l), _words((l+63)/64), _spare(spare), _bits((n+spare)*_words, 0)
+    , _parents(n), _slots(n+spare), _fitness(n), _counts(n), _holes(n), _dead(n+spare, 0), _rng(seed) {
+        for(size_t i=0; i<_parents.size(); ++i) {
+            _parents[i] = i;
+        }
+        for(size_t i=0; i<_slots.size(); ++i) {
+            _slots[i] = i;
+        }
+    }
+
+    //! Number of individuals.
+    size_t size() const { return _n; }
+
+    //! Number of sites per individual.
+    size_t repr_size() const { return _l; }
+
+    //! Number of spare rows.
+    size_t spare() const { return _spare; }
+
+    //! Returns a pointer to the first word of row i.
+    word_type* row(size_t i) { return &_bits[i*_words]; }
+    const word_type* row(size_t i) const { return &_bits[i*_words]; }
+
+    //! Returns site j of row i.
+    int get(size_t i, size_t j) const {
+        return static_cast<int>((row(i)[j/64] >> (j%64)) & 1);
+    }
+
+    //! Sets site j of row i to b.
+    void set(size_t i, size_t j, int b) {
+        word_type m=static_cast<word_type>(1) << (j%64);
+        word_type& w=row(i)[j/64];
+        w = b ? (w | m) : (w & ~m);
+    }
+
+    //! Copies row "from" over row "to".
+    void copy(size_t from, size_t to) {
+        std::memcpy(row(to), row(from), _words*sizeof(word_type));
+    }
+
+    //! Returns the engine's random number generator.
+    xorshift128plus& rng() { return _rng; }
+
+    // scratch space, used below:
+    vector<size_t>& parents() { return _parents; }
+    vector<size_t>& slots() { return _slots; }
+    vector<size_t>& fitness() { return _fitness; }
+    vector<size_t>& counts() { return _counts; }
+    vector<size_t>& holes() { return _holes; }
+    vector<char>& dead() { return _dead; }
+
+private:
+    size_t _n, _l, _words, _spare;
+    vector<word_type> _bits;
+    vector<size_t> _parents, _slots, _fitness, _counts, _holes;
+    vector<char> _dead;
+    xorshift128plus _rng;
+};
+
+/* Our fitness function, all-ones, on a row of the matrix:
+ */
+size_t all_ones(const packed_population& p, size_t i) {
+    const packed_population::word_type* r=p.row(i);
+    size_t n=0;
+    for(size_t j=0; j<(p.repr_size()+63)/64; ++j) {
+        n += __builtin_popcountll(r[j]);
+    }
+    return n;
+}
+
+/* Mutation has the same interface as generic_mutate, with a Mutator applied to
+ a site when p < a uniform random number (just like in part 5).  Since rows
+ live in the population, we name a row by its index:
+ */
+template <typename Mutator>
+void generic_mutate(packed_population& p, size_t i, Mutator m, double prob=0.01) {
+    for(size_t j=0; j<p.repr_size(); ++j) {
+        if(prob < p.rng().uniform()) {
+            p.set(i, j, m(p.get(i, j)));
+        }
+    }
+}
+
+/* Now for preferential survival.  compete() in part 3 walks around the
+ population, copying each individual into "next" when its fitness beats a
+ random number, until next is full.  The number of copies each individual gets
+ is all that matters, so we count them instead, and then overwrite each
+ individual that got no copies with an extra copy of one that got more than one.
+ Nothing is allocated, and only the rows that actually change are copied.
+
+ The walk starts at a random individual, since (unlike part 3) the population
+ isn't shuffled every update.
+ */
+void compete(packed_population& p) {
+    vector<size_t>& fitness=p.fitness();
+    vector<size_t>& counts=p.counts();
+    vector<size_t>& holes=p.holes();
+    for(size_t i=0; i<p.size(); ++i) {
+        fitness[i] = all_ones(p, i);
+        counts[i] = 0;
+    }
+
+    size_t total=0;
+    for(size_t i=p.rng().below(p.size()); total<p.size(); i=(i+1)%p.size()) {
+        if(fitness[i] >= p.rng().below(p.repr_size())) {
+            ++counts[i];
+            ++total;
+        }
+    }
+
+    size_t nholes=0;
+    for(size_t i=0; i<p.size(); ++i) {
+        if(counts[i] == 0) {
+            holes[nholes++] = i;
+        }
+    }
+    for(size_t i=0, h=0; i<p.size(); ++i) {
+        for( ; counts[i] > 1; --counts[i]) {
+            p.copy(i, holes[h++]);
+        }
+    }
+}
+
+/* And finally, selection.  This has the same interface as generic_random_selection,
+ and does the same thing: 5% of the population, chosen at random, have an
+ offspring (which is mutated with probability 1-pmutate, as before), and then
+ a random n (the population's size) of the parents and offspring survive.
+
+ Both "chosen at random" steps are partial Fisher-Yates shuffles of a
+ permutation of row indices: k random swaps choose k distinct rows, without
+ touching the rest.  Offspring are built in the spare rows.  When a row of the
+ population dies and a spare row survives, the spare row is copied into the
+ hole, so that the population is always rows [0, size()).
+ */
+template <typename Mutator>
+void generic_random_selection(packed_population& p, Mutator m, double pmutate=0.05) {
+    const size_t n=p.size();
+    const size_t k=std::min(p.spare(), static_cast<size_t>(0.05*n));
+    vector<size_t>& parents=p.parents();
+    vector<size_t>& slots=p.slots();
+
+    // choose k parents, and copy each into a spare row:
+    for(size_t j=0; j<k; ++j) {
+        std::swap(parents[j], parents[j + p.rng().below(n-j)]);
+        p.copy(parents[j], n+j);
+        if(pmutate < p.rng().uniform()) {
+            generic_mutate(p, n+j, m);
+        }
+    }
+
+    // choose k of the n+k rows to die:
+    for(size_t j=0; j<k; ++j) {
+        std::swap(slots[j], slots[j + p.rng().below(n+k-j)]);
+    }
+
+    // the rest survive.  every dead row in the population is a hole, and
+    // there are exactly as many surviving spare rows to fill them:
+    vector<size_t>& holes=p.holes();
+    size_t nholes=0;
+    for(size_t j=0; j<k; ++j) {
+        if(slots[j] < n) {
+            holes[nholes++] = slots[j];
+        }
+    }
+    vector<char>& dead=p.dead();
+    for(size_t j=0; j<k; ++j) {
+        dead[slots[j]] = 1;
+    }
+    for(size_t j=0, h=0; j<k; ++j) {
+        if(!dead[n+j]) {
+            p.copy(n+j, holes[h++]);
+        }
+    }
+    for(size_t j=0; j<k; ++j) {
+        dead[slots[j]] = 0;
+    }
+}
+
+/* Let's see how much faster this is...
+ */
+
+#endif